@@ -0,0 +1,85 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Structure a heap allocation is charged to. Untagged allocations (filters,
+// duplicate trackers, temporaries) go to Other.
+enum class AllocationTag : uint8_t {
+    Other,
+    Students,    // rows: Student objects and their strings, columns, arenas, dictionaries
+    NameIndex,   // name|surname lookup structure (index, or the scan columns)
+    EmailIndex,
+    Count
+};
+
+// Live heap bytes (as requested, without malloc's own overhead) and live
+// allocation count of one tag
+struct AllocationUsage {
+    int64_t bytes = 0;
+    int64_t allocations = 0;
+
+    AllocationUsage operator-(const AllocationUsage& other) const {
+        return {bytes - other.bytes, allocations - other.allocations};
+    }
+};
+
+// Heap allocations made by the process, in total and live per tag.
+// Fed by the replacement operator new/delete in main.cpp, which charge each
+// block to the tag current on the allocating thread and remember it in a
+// header so the free is charged back to the same tag. Everything stays 0 in
+// programs that do not install them, and AllocationScope is then a no-op.
+class AllocationCounter {
+public:
+    static constexpr size_t TAGS = static_cast<size_t>(AllocationTag::Count);
+
+    static inline std::atomic<size_t> allocations{0};
+    static inline std::atomic<int64_t> liveBytes[TAGS] = {};
+    static inline std::atomic<int64_t> liveAllocations[TAGS] = {};
+    static inline thread_local AllocationTag currentTag = AllocationTag::Other;
+
+    static size_t count() {
+        return allocations.load(std::memory_order_relaxed);
+    }
+
+    static AllocationUsage usage(AllocationTag tag) {
+        size_t i = static_cast<size_t>(tag);
+        return {liveBytes[i].load(std::memory_order_relaxed), liveAllocations[i].load(std::memory_order_relaxed)};
+    }
+
+    static void allocated(size_t size, AllocationTag tag) {
+        size_t i = static_cast<size_t>(tag);
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        liveBytes[i].fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+        liveAllocations[i].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void freed(size_t size, AllocationTag tag) {
+        size_t i = static_cast<size_t>(tag);
+        liveBytes[i].fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+        liveAllocations[i].fetch_sub(1, std::memory_order_relaxed);
+    }
+};
+
+// Charges the calling thread's allocations to `tag` until destroyed.
+// Scopes nest; parallelFor hands the current tag on to its workers.
+class AllocationScope {
+private:
+    AllocationTag previous;
+
+public:
+    explicit AllocationScope(AllocationTag tag) : previous(AllocationCounter::currentTag) {
+        AllocationCounter::currentTag = tag;
+    }
+
+    ~AllocationScope() {
+        AllocationCounter::currentTag = previous;
+    }
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+};
+
+#endif
@@ -0,0 +1,249 @@
+#ifndef ARENA_DB_H
+#define ARENA_DB_H
+
+#include "Database.h"
+#include "StringArena.h"
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <string_view>
+
+// Variant 5: HashMap layout over arena-backed strings
+// Every string byte of the loaded dataset lives in one StringArena; rows are
+// StudentViews into it and index keys are views too, so a load makes no
+// per-field allocation and clear()/reload frees everything in one go.
+// The name|surname key is stored once and the row's name/surname point into
+// it. Rows sharing a key are chained through nextSameName instead of a
+// vector per key.
+class ArenaDB : public IDatabase {
+private:
+    struct NamePostings {
+        size_t first;
+        size_t last;
+    };
+
+    static constexpr size_t NO_ROW = static_cast<size_t>(-1);
+
+    StringArena arena;
+    std::vector<StudentView> students;
+    std::vector<size_t> nextSameName;
+    std::unordered_map<std::string_view, NamePostings> nameIndex;
+    std::unordered_map<std::string_view, size_t> emailIndex;
+    std::unordered_set<std::string_view> groups;
+    DatabaseOptions options;
+    BloomFilter nameFilter;
+    PerfectHashIndex perfectEmails;
+
+    // Calls fn with name|surname, built on the stack when it fits
+    template <typename Fn>
+    static auto withNameKey(std::string_view name, std::string_view surname, Fn fn) {
+        char buffer[128];
+        std::string overflow;
+        size_t size = name.size() + 1 + surname.size();
+        char* key = buffer;
+        if (size > sizeof(buffer)) {
+            overflow.resize(size);
+            key = overflow.data();
+        }
+        std::memcpy(key, name.data(), name.size());
+        key[name.size()] = '|';
+        std::memcpy(key + name.size() + 1, surname.data(), surname.size());
+        return fn(std::string_view(key, size));
+    }
+
+    std::string_view internGroup(std::string_view group) {
+        auto it = groups.find(group);
+        if (it != groups.end()) return *it;
+        std::string_view stored = arena.store(group);
+        groups.insert(stored);
+        return stored;
+    }
+
+    // The arena (key bytes included, since rows point into them), rows and
+    // group set are charged to Students; nameIndex and its chains to NameIndex
+    void appendRow(const StudentView& parsed) {
+        AllocationScope rows(AllocationTag::Students);
+        size_t idx = students.size();
+        StudentView row = parsed;
+
+        auto nameIt = withNameKey(parsed.m_name, parsed.m_surname, [&](std::string_view key) {
+            return nameIndex.find(key);
+        });
+        if (nameIt == nameIndex.end()) {
+            std::string_view key = arena.storeJoined(parsed.m_name, '|', parsed.m_surname);
+            AllocationScope scope(AllocationTag::NameIndex);
+            nameIt = nameIndex.emplace(key, NamePostings{idx, idx}).first;
+        } else {
+            nextSameName[nameIt->second.last] = idx;
+            nameIt->second.last = idx;
+        }
+        row.m_name = nameIt->first.substr(0, parsed.m_name.size());
+        row.m_surname = nameIt->first.substr(parsed.m_name.size() + 1);
+        row.m_email = arena.store(parsed.m_email);
+        row.m_group = internGroup(parsed.m_group);
+        row.m_phone_number = arena.store(parsed.m_phone_number);
+
+        students.push_back(row);
+        {
+            AllocationScope scope(AllocationTag::NameIndex);
+            nextSameName.push_back(NO_ROW);
+        }
+        if (!options.perfectEmailIndex) {
+            AllocationScope scope(AllocationTag::EmailIndex);
+            emailIndex[row.m_email] = idx;
+        }
+    }
+
+    std::string_view emailOf(size_t row) const {
+        return students[row].m_email;
+    }
+
+    // Row of email, or NOT_FOUND
+    size_t findEmailRow(std::string_view email) const {
+        if (options.perfectEmailIndex) {
+            return findPerfectEmail(perfectEmails, email, [this](uint32_t row) { return emailOf(row); });
+        }
+        auto it = emailIndex.find(email);
+        return it == emailIndex.end() ? NOT_FOUND : it->second;
+    }
+
+    void buildPerfectEmails() {
+        perfectEmails.clear();
+        if (options.perfectEmailIndex) {
+            buildPerfectEmailIndex(perfectEmails, students.size(), [this](uint32_t row) { return emailOf(row); });
+        }
+    }
+
+    void clear() {
+        students.clear();
+        nextSameName.clear();
+        nameIndex.clear();
+        emailIndex.clear();
+        groups.clear();
+        arena.clear();
+    }
+
+public:
+    explicit ArenaDB(DatabaseOptions options = {}) : options(options) {}
+
+    void loadFromFile(const std::string& filename) override {
+        CsvReader reader(filename);
+
+        beginLoad();
+        reader.forEachLine([&](std::string_view line) {
+            appendRow(StudentView::fromCSV(line));
+        });
+        endLoad();
+    }
+
+    bool beginLoad() override {
+        clear();
+        return true;
+    }
+
+    // The strings are copied into the arena, so the rows are only read
+    void appendLoadedRows(std::vector<Student>& rows) override {
+        for (const Student& s : rows) {
+            appendRow(s);
+        }
+        rows.clear();
+    }
+
+    void endLoad() override {
+        buildPerfectEmails();
+        if (options.nameFilter) buildNameFilter(nameFilter);
+    }
+
+    bool saveSnapshot(const std::string& filename) const override {
+        SnapshotWriter writer;
+        for (const auto& s : students) {
+            writer.addStudent(s);
+        }
+        perfectEmails.forEachValue([&](uint32_t row) { writer.addEmailRow(row); });
+        for (const auto& [email, idx] : emailIndex) {
+            writer.addEmailRow(idx);
+        }
+        return writer.write(filename);
+    }
+
+    bool loadSnapshot(const std::string& filename) override {
+        SnapshotReader reader(filename);
+        if (!reader.isValid()) return false;
+
+        clear();
+        for (size_t row = 0; row < reader.rowCount(); row++) {
+            appendRow(reader.view(row));
+        }
+        buildPerfectEmails();
+        if (options.nameFilter) buildNameFilter(nameFilter);
+        return true;
+    }
+
+    RowSpan findRowsByNameSurname(const std::string& name, const std::string& surname,
+                                  std::vector<size_t>& scratch) const override {
+        if (options.nameFilter && !nameFilter.mayContain(hashKeyParts(name, surname))) return RowSpan();
+        scratch.clear();
+        auto it = withNameKey(name, surname, [&](std::string_view key) {
+            return nameIndex.find(key);
+        });
+        if (it != nameIndex.end()) {
+            for (size_t idx = it->second.first; idx != NO_ROW; idx = nextSameName[idx]) {
+                scratch.push_back(idx);
+            }
+        }
+        return RowSpan(scratch);
+    }
+
+    std::set<std::string> findGroupsWithDuplicateNameSurname() override {
+        std::set<std::string> result;
+        for (const auto& [key, postings] : nameIndex) {
+            if (postings.first != postings.last) {
+                std::set<std::string_view> keyGroups;
+                for (size_t idx = postings.first; idx != NO_ROW; idx = nextSameName[idx]) {
+                    keyGroups.insert(students[idx].m_group);
+                }
+                if (keyGroups.size() > 1) {
+                    result.insert(keyGroups.begin(), keyGroups.end());
+                }
+            }
+        }
+        return result;
+    }
+
+    bool updateGroupByEmail(const std::string& email, const std::string& newGroup) override {
+        size_t row = findEmailRow(email);
+        if (row != NOT_FOUND) {
+            students[row].m_group = internGroup(newGroup);
+            return true;
+        }
+        return false;
+    }
+
+    size_t rowCount() const override {
+        return students.size();
+    }
+
+    StudentView getRow(size_t row) const override {
+        return students[row];
+    }
+
+    size_t getMemoryUsage() const override {
+        // Node: key view + value + next pointer + cached hash, plus one bucket pointer
+        const size_t nodeOverhead = sizeof(std::string_view) + 3 * sizeof(void*);
+        size_t size = arena.getMemoryUsage();
+        size += students.capacity() * sizeof(StudentView) + nextSameName.capacity() * sizeof(size_t);
+        size += nameIndex.size() * (nodeOverhead + sizeof(NamePostings));
+        size += emailIndex.size() * (nodeOverhead + sizeof(size_t)) + perfectEmails.getMemoryUsage();
+        size += groups.size() * nodeOverhead;
+        if (options.nameFilter) {
+            size += nameFilter.getMemoryUsage();
+        }
+        return size;
+    }
+
+    const BloomFilter* getNameFilter() const override {
+        return options.nameFilter ? &nameFilter : nullptr;
+    }
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+
+// Cache-blocked Bloom filter over 64-bit key hashes.
+//
+// Each key sets HASHES bits inside one 64-byte block, so a query touches a
+// single cache line. A "no" answer is exact; a "maybe" is wrong with a
+// probability of about 1% at the default 10 bits per key.
+class BloomFilter {
+private:
+    static constexpr size_t BLOCK_BITS = 512;
+    static constexpr size_t HASHES = 6;
+
+    struct alignas(64) Block {
+        uint64_t words[BLOCK_BITS / 64];
+    };
+
+    std::vector<Block> blocks;
+    size_t keys = 0;
+
+    size_t blockIndex(uint64_t hash) const {
+        return ((hash >> 32) * blocks.size()) >> 32;
+    }
+
+    // HASHES bit positions inside the block, 9 bits each from a remixed hash
+    template <typename Fn>
+    static void forEachBit(uint64_t hash, Fn fn) {
+        uint64_t bits = hash * 0x9e3779b97f4a7c15ULL;
+        for (size_t i = 0; i < HASHES; i++) {
+            fn(bits & (BLOCK_BITS - 1));
+            bits >>= 9;
+        }
+    }
+
+public:
+    // Empties the filter and sizes it for expectedKeys keys
+    void reset(size_t expectedKeys, size_t bitsPerKey = 10) {
+        size_t blockCount = (expectedKeys * bitsPerKey + BLOCK_BITS - 1) / BLOCK_BITS;
+        blocks.assign(blockCount > 0 ? blockCount : 1, Block{});
+        keys = 0;
+    }
+
+    void clear() {
+        blocks.clear();
+        keys = 0;
+    }
+
+    // A filter never sized takes one block; owners that add rows over time
+    // rebuild it at its real size (see upsertStudents)
+    void add(uint64_t hash) {
+        if (blocks.empty()) reset(1);
+        Block& block = blocks[blockIndex(hash)];
+        forEachBit(hash, [&](size_t bit) {
+            block.words[bit / 64] |= uint64_t(1) << (bit % 64);
+        });
+        keys++;
+    }
+
+    bool mayContain(uint64_t hash) const {
+        if (blocks.empty()) return true;
+        const Block& block = blocks[blockIndex(hash)];
+        bool result = true;
+        forEachBit(hash, [&](size_t bit) {
+            result &= (block.words[bit / 64] >> (bit % 64)) & 1;
+        });
+        return result;
+    }
+
+    size_t size() const { return keys; }
+
+    // False positive rate predicted from the fraction of bits set
+    double estimatedFalsePositiveRate() const {
+        if (blocks.empty()) return 1.0;
+        size_t setBits = 0;
+        for (const Block& block : blocks) {
+            for (uint64_t word : block.words) {
+                setBits += __builtin_popcountll(word);
+            }
+        }
+        return std::pow(double(setBits) / double(blocks.size() * BLOCK_BITS), double(HASHES));
+    }
+
+    size_t getMemoryUsage() const {
+        return blocks.capacity() * sizeof(Block);
+    }
+};
+
+#endif
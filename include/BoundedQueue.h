@@ -0,0 +1,92 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// Fixed-capacity lock-free queue for any number of producers and consumers,
+// after Dmitry Vyukov's bounded MPMC queue.
+//
+// Each cell carries a sequence number that says whose turn it is: a cell at
+// position pos is free for the producer claiming pos when its sequence is
+// pos, and full for the consumer claiming pos when it is pos + 1. Producers
+// and consumers claim positions with one CAS on their own counter and never
+// touch each other's, so a push or pop costs one CAS and two cell accesses.
+// tryPush and tryPop never block: they return false when the queue is full
+// or empty and leave waiting (and giving up) to the caller.
+template <typename T>
+class BoundedQueue {
+private:
+    struct alignas(64) Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> pushPos{0};
+    alignas(64) std::atomic<size_t> popPos{0};
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit BoundedQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size *= 2;
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    size_t capacity() const { return mask + 1; }
+
+    // Moves value in; false (value untouched) if the queue is full
+    bool tryPush(T& value) {
+        size_t pos = pushPos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = pushPos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Moves the oldest value out; false if the queue is empty
+    bool tryPop(T& value) {
+        size_t pos = popPos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (popPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = popPos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,256 @@
+#ifndef CHANGE_LOG_H
+#define CHANGE_LOG_H
+
+#include "Snapshot.h"
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <iterator>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+// When appended records are made durable. A commit hands every pending
+// record to the kernel in one write() and then calls fdatasync() once, so
+// all updates that arrived meanwhile share that fsync (group commit).
+struct CommitPolicy {
+    // Commit once this many records are pending; 0 = never by count
+    size_t batchSize = 1;
+    // Commit at most this long after the oldest pending record, from a
+    // background thread; 0 = no timer
+    uint64_t intervalMicros = 0;
+};
+
+const char CHANGE_LOG_MAGIC[8] = {'S', 'T', 'D', 'B', 'W', 'L', 'O', 'G'};
+const uint32_t CHANGE_LOG_VERSION = 1;
+
+// Append-only binary log of group changes (email -> new group).
+//
+// File layout (native endianness): the 8 byte magic and a uint32 version
+// padded to 16 bytes, then one record per change: uint32 email length,
+// uint32 group length, the email and group bytes, and a 64-bit checksum of
+// everything before it in the record. replay() stops at the first torn or
+// corrupt record, the tail a crash in the middle of a write leaves behind,
+// and open() cuts the file there so new records follow the last valid one.
+//
+// append() may be called from several threads. With neither a batch size
+// nor an interval, records are only written when the buffer fills and
+// fsynced only by commit() and close().
+class ChangeLog {
+private:
+    static constexpr size_t HEADER_SIZE = 16;
+    static constexpr size_t BUFFER_LIMIT = 1 << 20;
+
+    using Clock = std::chrono::steady_clock;
+
+    int fd = -1;
+    CommitPolicy policy;
+
+    std::mutex mutex;            // guards the fields below
+    std::string pending;
+    size_t pendingRecords = 0;
+    Clock::time_point oldestPending;
+    bool stopping = false;
+    bool failed = false;
+    bool unsynced = false;       // written without fdatasync since the last sync
+    size_t records = 0;
+    size_t syncs = 0;
+
+    std::mutex ioMutex;          // one commit at a time, so buffers reach the file in order
+    std::condition_variable timerWake;
+    std::thread timer;
+
+    // Writes the pending records, then fdatasync() when sync is set
+    bool flushPending(bool sync) {
+        std::lock_guard io(ioMutex);
+        std::string batch;
+        {
+            std::lock_guard lock(mutex);
+            batch.swap(pending);
+            pendingRecords = 0;
+        }
+        bool ok = fd >= 0;
+        for (size_t done = 0; ok && done < batch.size();) {
+            ssize_t written = ::write(fd, batch.data() + done, batch.size() - done);
+            ok = written > 0;
+            done += ok ? written : 0;
+        }
+        bool synced = ok && sync && (!batch.empty() || unsynced);
+        if (synced) ok = ::fdatasync(fd) == 0;
+
+        std::lock_guard lock(mutex);
+        failed |= !ok;
+        syncs += synced;
+        unsynced = !synced && (unsynced || !batch.empty());
+        if (pending.empty()) {
+            // Reuse the written buffer's capacity for the next batch
+            batch.clear();
+            pending.swap(batch);
+        }
+        return ok;
+    }
+
+    void runTimer() {
+        std::unique_lock lock(mutex);
+        while (!stopping) {
+            if (pendingRecords == 0) {
+                timerWake.wait(lock);
+                continue;
+            }
+            auto deadline = oldestPending + std::chrono::microseconds(policy.intervalMicros);
+            if (Clock::now() < deadline) {
+                timerWake.wait_until(lock, deadline);
+                continue;
+            }
+            lock.unlock();
+            flushPending(true);
+            lock.lock();
+        }
+    }
+
+    static uint64_t recordChecksum(const char* record, size_t size) {
+        return snapshotChecksum(record, size);
+    }
+
+public:
+    ChangeLog() = default;
+
+    ~ChangeLog() {
+        close();
+    }
+
+    ChangeLog(const ChangeLog&) = delete;
+    ChangeLog& operator=(const ChangeLog&) = delete;
+
+    // Calls apply(email, group) for every valid record of `filename`, in
+    // order; returns how many were applied (0 for a missing or foreign file)
+    template <typename Apply>
+    static size_t replay(const std::string& filename, Apply apply, size_t* validBytes = nullptr) {
+        std::ifstream file(filename, std::ios::binary);
+        std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (validBytes) *validBytes = 0;
+        const char* data = contents.data();
+        size_t size = contents.size();
+        if (size < HEADER_SIZE || std::memcmp(data, CHANGE_LOG_MAGIC, sizeof(CHANGE_LOG_MAGIC)) != 0) return 0;
+        uint32_t version;
+        std::memcpy(&version, data + sizeof(CHANGE_LOG_MAGIC), sizeof(version));
+        if (version != CHANGE_LOG_VERSION) return 0;
+
+        size_t pos = HEADER_SIZE, applied = 0;
+        for (;;) {
+            uint32_t lengths[2];
+            if (size - pos < sizeof(lengths)) break;
+            std::memcpy(lengths, data + pos, sizeof(lengths));
+            size_t body = sizeof(lengths) + size_t(lengths[0]) + lengths[1];
+            if (size - pos < body + sizeof(uint64_t)) break;
+            uint64_t checksum;
+            std::memcpy(&checksum, data + pos + body, sizeof(checksum));
+            if (checksum != recordChecksum(data + pos, body)) break;
+            const char* email = data + pos + sizeof(lengths);
+            apply(std::string(email, lengths[0]), std::string(email + lengths[0], lengths[1]));
+            pos += body + sizeof(checksum);
+            applied++;
+        }
+        if (validBytes) *validBytes = pos;
+        return applied;
+    }
+
+    // Opens `filename` for appending, creating it if needed, and drops any
+    // torn tail past validBytes (from replay); false on I/O errors
+    bool open(const std::string& filename, const CommitPolicy& commitPolicy, size_t validBytes) {
+        close();
+        policy = commitPolicy;
+        failed = false;
+        records = 0;
+        syncs = 0;
+        stopping = false;
+        unsynced = false;
+
+        fd = ::open(filename.c_str(), O_WRONLY | O_CREAT, 0644);
+        if (fd < 0) return false;
+        bool ok = true;
+        if (validBytes < HEADER_SIZE) {
+            char header[HEADER_SIZE] = {};
+            std::memcpy(header, CHANGE_LOG_MAGIC, sizeof(CHANGE_LOG_MAGIC));
+            std::memcpy(header + sizeof(CHANGE_LOG_MAGIC), &CHANGE_LOG_VERSION, sizeof(CHANGE_LOG_VERSION));
+            ok = ::ftruncate(fd, 0) == 0 && ::write(fd, header, HEADER_SIZE) == static_cast<ssize_t>(HEADER_SIZE);
+        } else {
+            ok = ::ftruncate(fd, validBytes) == 0 && ::lseek(fd, 0, SEEK_END) >= 0;
+        }
+        ok = ok && ::fdatasync(fd) == 0;
+        if (!ok) {
+            close();
+            return false;
+        }
+        if (policy.intervalMicros > 0) {
+            timer = std::thread([this] { runTimer(); });
+        }
+        return true;
+    }
+
+    bool isOpen() const { return fd >= 0; }
+
+    void append(std::string_view email, std::string_view group) {
+        bool commitNow;
+        {
+            std::lock_guard lock(mutex);
+            uint32_t lengths[2] = {static_cast<uint32_t>(email.size()), static_cast<uint32_t>(group.size())};
+            size_t start = pending.size();
+            pending.append(reinterpret_cast<const char*>(lengths), sizeof(lengths));
+            pending += email;
+            pending += group;
+            uint64_t checksum = recordChecksum(pending.data() + start, pending.size() - start);
+            pending.append(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+
+            if (pendingRecords++ == 0) {
+                oldestPending = Clock::now();
+                if (policy.intervalMicros > 0) timerWake.notify_one();
+            }
+            records++;
+            commitNow = (policy.batchSize > 0 && pendingRecords >= policy.batchSize) || pending.size() >= BUFFER_LIMIT;
+        }
+        if (commitNow) {
+            flushPending(policy.batchSize > 0 || policy.intervalMicros > 0);
+        }
+    }
+
+    // Writes and fsyncs everything appended so far; false if any write failed
+    bool commit() {
+        flushPending(true);
+        std::lock_guard lock(mutex);
+        return !failed;
+    }
+
+    // Commits, stops the timer and closes the file; false if any write failed
+    bool close() {
+        if (fd < 0) return !failed;
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        timerWake.notify_one();
+        if (timer.joinable()) timer.join();
+        bool ok = commit();
+        ok &= ::close(fd) == 0;
+        fd = -1;
+        return ok;
+    }
+
+    // Records appended and fsyncs made since open()
+    size_t recordCount() {
+        std::lock_guard lock(mutex);
+        return records;
+    }
+
+    size_t syncCount() {
+        std::lock_guard lock(mutex);
+        return syncs;
+    }
+};
+
+#endif
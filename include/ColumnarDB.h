@@ -0,0 +1,326 @@
+#ifndef COLUMNAR_DB_H
+#define COLUMNAR_DB_H
+
+#include "Database.h"
+#include "StringDictionary.h"
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <stdexcept>
+
+// Variant 4: Columnar (struct-of-arrays) storage
+// Names, surnames and groups are dictionary encoded into 32-bit ids, emails and
+// phone numbers share one string heap, every other field is its own column.
+// Each distinct (name, surname) pair gets a dense pair id, so duplicate
+// detection only compares integers, and the rows of every pair are grouped
+// into one postings array at the end of a load, so a name lookup returns a
+// span into it.
+class ColumnarDB : public IDatabase {
+private:
+    StringDictionary names;
+    StringDictionary surnames;
+    StringDictionary groups;
+
+    std::vector<uint32_t> nameIds;
+    std::vector<uint32_t> surnameIds;
+    std::vector<uint32_t> pairIds;
+    std::vector<uint32_t> groupIds;
+    std::vector<int32_t> birthYears;
+    std::vector<int32_t> birthMonths;
+    std::vector<int32_t> birthDays;
+    std::vector<float> ratings;
+
+    // Row i owns heap[rowOffsets[i], rowOffsets[i + 1]): email then phone number.
+    // Offsets are 32-bit, so the heap is capped at 4 GiB (see appendRow).
+    std::string heap;
+    std::vector<uint32_t> rowOffsets{0};
+    std::vector<uint32_t> emailLengths;
+
+    std::unordered_map<uint64_t, uint32_t> pairIndex;
+    std::vector<size_t> pairOffsets;   // pair id -> start in pairRows
+    std::vector<size_t> pairRows;      // rows grouped by pair id, ascending
+    // Open addressing email table: 0 = empty, otherwise row + 1
+    std::vector<uint32_t> emailSlots;
+    DatabaseOptions options;
+    BloomFilter nameFilter;
+    PerfectHashIndex perfectEmails;
+
+    static uint64_t pairKey(uint32_t nameId, uint32_t surnameId) {
+        return (static_cast<uint64_t>(nameId) << 32) | surnameId;
+    }
+
+    std::string_view emailOf(size_t row) const {
+        return std::string_view(heap.data() + rowOffsets[row], emailLengths[row]);
+    }
+
+    std::string_view phoneOf(size_t row) const {
+        size_t begin = rowOffsets[row] + emailLengths[row];
+        return std::string_view(heap.data() + begin, rowOffsets[row + 1] - begin);
+    }
+
+    // Slot holding email, or the empty slot where it would go
+    size_t probeEmail(std::string_view email) const {
+        size_t mask = emailSlots.size() - 1;
+        size_t i = std::hash<std::string_view>()(email) & mask;
+        while (emailSlots[i] != 0 && emailOf(emailSlots[i] - 1) != email) {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    void growEmailTable() {
+        std::vector<uint32_t> oldSlots(std::max<size_t>(16, emailSlots.size() * 2), 0);
+        oldSlots.swap(emailSlots);
+        for (uint32_t slot : oldSlots) {
+            if (slot != 0) emailSlots[probeEmail(emailOf(slot - 1))] = slot;
+        }
+    }
+
+    void indexEmail(size_t row) {
+        if ((row + 1) * 2 > emailSlots.size()) growEmailTable();
+        // Later rows with the same email win, as in the other variants
+        emailSlots[probeEmail(emailOf(row))] = static_cast<uint32_t>(row + 1);
+    }
+
+    size_t findEmail(std::string_view email) const {
+        if (options.perfectEmailIndex) {
+            return findPerfectEmail(perfectEmails, email, [this](uint32_t row) { return emailOf(row); });
+        }
+        if (emailSlots.empty()) return NOT_FOUND;
+        uint32_t slot = emailSlots[probeEmail(email)];
+        return slot == 0 ? NOT_FOUND : slot - 1;
+    }
+
+    // The pair index and pair id column are charged to NameIndex, the email
+    // table to EmailIndex, dictionaries and the other columns to Students
+    void appendRow(const Student& s) {
+        if (heap.size() + s.m_email.size() + s.m_phone_number.size() > UINT32_MAX) {
+            throw std::length_error("Email and phone heap exceeds 4 GiB at row " + std::to_string(nameIds.size()));
+        }
+        AllocationScope rows(AllocationTag::Students);
+        size_t row = nameIds.size();
+        uint32_t nameId = names.intern(s.m_name);
+        uint32_t surnameId = surnames.intern(s.m_surname);
+        {
+            AllocationScope scope(AllocationTag::NameIndex);
+            auto pair = pairIndex.emplace(pairKey(nameId, surnameId), static_cast<uint32_t>(pairIndex.size())).first;
+            pairIds.push_back(pair->second);
+        }
+
+        nameIds.push_back(nameId);
+        surnameIds.push_back(surnameId);
+        groupIds.push_back(groups.intern(s.m_group));
+        birthYears.push_back(s.m_birth_year);
+        birthMonths.push_back(s.m_birth_month);
+        birthDays.push_back(s.m_birth_day);
+        ratings.push_back(s.m_rating);
+
+        heap += s.m_email;
+        heap += s.m_phone_number;
+        emailLengths.push_back(static_cast<uint32_t>(s.m_email.size()));
+        rowOffsets.push_back(static_cast<uint32_t>(heap.size()));
+
+        if (!options.perfectEmailIndex) {
+            AllocationScope scope(AllocationTag::EmailIndex);
+            indexEmail(row);
+        }
+    }
+
+    void buildPerfectEmails() {
+        perfectEmails.clear();
+        if (options.perfectEmailIndex) {
+            buildPerfectEmailIndex(perfectEmails, nameIds.size(), [this](uint32_t row) { return emailOf(row); });
+        }
+    }
+
+    // Counting sort of rows by pair id keeps each pair's rows ascending
+    void buildPairRows() {
+        AllocationScope scope(AllocationTag::NameIndex);
+        size_t rows = pairIds.size();
+        pairOffsets.assign(pairIndex.size() + 1, 0);
+        for (uint32_t pair : pairIds) pairOffsets[pair + 1]++;
+        for (size_t p = 0; p < pairIndex.size(); p++) pairOffsets[p + 1] += pairOffsets[p];
+        pairRows.resize(rows);
+        std::vector<size_t> cursor(pairOffsets.begin(), pairOffsets.end() - 1);
+        for (size_t i = 0; i < rows; i++) {
+            pairRows[cursor[pairIds[i]]++] = i;
+        }
+    }
+
+    RowSpan pairPostings(uint32_t pair) const {
+        return RowSpan(pairRows.data() + pairOffsets[pair], pairOffsets[pair + 1] - pairOffsets[pair]);
+    }
+
+    void clear() {
+        names.clear();
+        surnames.clear();
+        groups.clear();
+        nameIds.clear();
+        surnameIds.clear();
+        pairIds.clear();
+        groupIds.clear();
+        birthYears.clear();
+        birthMonths.clear();
+        birthDays.clear();
+        ratings.clear();
+        heap.clear();
+        rowOffsets.assign(1, 0);
+        emailLengths.clear();
+        pairIndex.clear();
+        pairOffsets.clear();
+        pairRows.clear();
+        emailSlots.clear();
+    }
+
+    template <typename T>
+    static size_t columnBytes(const std::vector<T>& column) {
+        return column.capacity() * sizeof(T);
+    }
+
+public:
+    explicit ColumnarDB(DatabaseOptions options = {}) : options(options) {}
+
+    void loadFromFile(const std::string& filename) override {
+        CsvReader reader(filename);
+
+        beginLoad();
+        reader.forEachStudent([&](Student&& s) {
+            appendRow(s);
+        });
+        endLoad();
+    }
+
+    bool beginLoad() override {
+        clear();
+        return true;
+    }
+
+    void appendLoadedRows(std::vector<Student>& rows) override {
+        for (const Student& s : rows) {
+            appendRow(s);
+        }
+        rows.clear();
+    }
+
+    void endLoad() override {
+        buildPairRows();
+        buildPerfectEmails();
+        if (options.nameFilter) buildNameFilter(nameFilter);
+    }
+
+    bool saveSnapshot(const std::string& filename) const override {
+        SnapshotWriter writer;
+        for (size_t row = 0; row < nameIds.size(); row++) {
+            writer.addStudent(getRow(row));
+        }
+        for (uint32_t pair = 0; pair < pairIndex.size(); pair++) {
+            writer.addNameEntry(pairPostings(pair));
+        }
+        perfectEmails.forEachValue([&](uint32_t row) { writer.addEmailRow(row); });
+        for (uint32_t slot : emailSlots) {
+            if (slot != 0) writer.addEmailRow(slot - 1);
+        }
+        return writer.write(filename);
+    }
+
+    bool loadSnapshot(const std::string& filename) override {
+        SnapshotReader reader(filename);
+        if (!reader.isValid()) return false;
+
+        clear();
+        for (size_t row = 0; row < reader.rowCount(); row++) {
+            appendRow(reader.student(row));
+        }
+        buildPairRows();
+        buildPerfectEmails();
+        if (options.nameFilter) buildNameFilter(nameFilter);
+        return true;
+    }
+
+    RowSpan findRowsByNameSurname(const std::string& name, const std::string& surname,
+                                  std::vector<size_t>& scratch) const override {
+        if (options.nameFilter && !nameFilter.mayContain(hashKeyParts(name, surname))) return RowSpan();
+        uint32_t nameId, surnameId;
+        if (!names.find(name, nameId) || !surnames.find(surname, surnameId)) return RowSpan();
+
+        auto it = pairIndex.find(pairKey(nameId, surnameId));
+        if (it == pairIndex.end()) return RowSpan();
+        return pairPostings(it->second);
+    }
+
+    std::set<std::string> findGroupsWithDuplicateNameSurname() override {
+        const uint32_t NO_GROUP = UINT32_MAX;
+        const uint32_t MANY_GROUPS = UINT32_MAX - 1;
+
+        // First group seen per pair, or MANY_GROUPS once a second one shows up
+        std::vector<uint32_t> pairGroup(pairIndex.size(), NO_GROUP);
+        for (size_t row = 0; row < pairIds.size(); row++) {
+            uint32_t& g = pairGroup[pairIds[row]];
+            if (g == NO_GROUP) {
+                g = groupIds[row];
+            } else if (g != groupIds[row]) {
+                g = MANY_GROUPS;
+            }
+        }
+
+        std::vector<bool> marked(groups.size(), false);
+        for (size_t row = 0; row < pairIds.size(); row++) {
+            if (pairGroup[pairIds[row]] == MANY_GROUPS) {
+                marked[groupIds[row]] = true;
+            }
+        }
+
+        std::set<std::string> result;
+        for (uint32_t id = 0; id < marked.size(); id++) {
+            if (marked[id]) result.emplace(groups.get(id));
+        }
+        return result;
+    }
+
+    bool updateGroupByEmail(const std::string& email, const std::string& newGroup) override {
+        size_t row = findEmail(email);
+        if (row == NOT_FOUND) return false;
+        groupIds[row] = groups.intern(newGroup);
+        return true;
+    }
+
+    size_t rowCount() const override {
+        return nameIds.size();
+    }
+
+    // Strings point into the dictionaries and the heap
+    StudentView getRow(size_t row) const override {
+        StudentView s;
+        s.m_name = names.get(nameIds[row]);
+        s.m_surname = surnames.get(surnameIds[row]);
+        s.m_email = emailOf(row);
+        s.m_birth_year = birthYears[row];
+        s.m_birth_month = birthMonths[row];
+        s.m_birth_day = birthDays[row];
+        s.m_group = groups.get(groupIds[row]);
+        s.m_rating = ratings[row];
+        s.m_phone_number = phoneOf(row);
+        return s;
+    }
+
+    size_t getMemoryUsage() const override {
+        size_t size = names.getMemoryUsage() + surnames.getMemoryUsage() + groups.getMemoryUsage();
+        size += columnBytes(nameIds) + columnBytes(surnameIds) + columnBytes(pairIds) + columnBytes(groupIds);
+        size += columnBytes(birthYears) + columnBytes(birthMonths) + columnBytes(birthDays) + columnBytes(ratings);
+        size += heap.capacity() + columnBytes(rowOffsets) + columnBytes(emailLengths);
+        size += columnBytes(emailSlots) + perfectEmails.getMemoryUsage();
+        size += columnBytes(pairOffsets) + columnBytes(pairRows);
+        // Node per pair plus bucket pointer
+        size += pairIndex.size() * (sizeof(uint64_t) + sizeof(uint32_t) + 2 * sizeof(void*));
+        if (options.nameFilter) {
+            size += nameFilter.getMemoryUsage();
+        }
+        return size;
+    }
+
+    const BloomFilter* getNameFilter() const override {
+        return options.nameFilter ? &nameFilter : nullptr;
+    }
+};
+
+#endif
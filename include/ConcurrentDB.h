@@ -0,0 +1,420 @@
+#ifndef CONCURRENT_DB_H
+#define CONCURRENT_DB_H
+
+#include "Database.h"
+#include <shared_mutex>
+#include <mutex>
+#include <array>
+#include <unordered_set>
+
+// Makes any variant safe to share between threads with one reader/writer lock:
+// queries run concurrently under a shared lock, updates and loads take it
+// exclusively. Simple, but every update stalls all readers.
+// A RowSpan or StudentView obtained here may be invalidated by an update made
+// by another thread (same lifetime rule as IDatabase).
+class SharedLockDB : public IDatabase {
+private:
+    IDatabase& db;
+    mutable std::shared_mutex mutex;
+
+public:
+    explicit SharedLockDB(IDatabase& db) : db(db) {}
+
+    void loadFromFile(const std::string& filename) override {
+        std::unique_lock lock(mutex);
+        db.loadFromFile(filename);
+    }
+
+    void loadFromFileParallel(const std::string& filename, size_t threads) override {
+        std::unique_lock lock(mutex);
+        db.loadFromFileParallel(filename, threads);
+    }
+
+    bool saveSnapshot(const std::string& filename) const override {
+        std::shared_lock lock(mutex);
+        return db.saveSnapshot(filename);
+    }
+
+    bool loadSnapshot(const std::string& filename) override {
+        std::unique_lock lock(mutex);
+        return db.loadSnapshot(filename);
+    }
+
+    RowSpan findRowsByNameSurname(const std::string& name, const std::string& surname,
+                                  std::vector<size_t>& scratch) const override {
+        std::shared_lock lock(mutex);
+        return db.findRowsByNameSurname(name, surname, scratch);
+    }
+
+    std::set<std::string> findGroupsWithDuplicateNameSurname() override {
+        std::shared_lock lock(mutex);
+        return db.findGroupsWithDuplicateNameSurname();
+    }
+
+    bool updateGroupByEmail(const std::string& email, const std::string& newGroup) override {
+        std::unique_lock lock(mutex);
+        return db.updateGroupByEmail(email, newGroup);
+    }
+
+    // One lock acquisition for the whole batch
+    void findRowsByNameSurnameBatch(const std::vector<NameQuery>& queries,
+                                    std::vector<RowSpan>& results, std::vector<size_t>& scratch) const override {
+        std::shared_lock lock(mutex);
+        db.findRowsByNameSurnameBatch(queries, results, scratch);
+    }
+
+    size_t updateGroupByEmailBatch(const std::vector<GroupUpdate>& updates) override {
+        std::unique_lock lock(mutex);
+        return db.updateGroupByEmailBatch(updates);
+    }
+
+    bool upsertStudents(std::vector<Student> rows) override {
+        std::unique_lock lock(mutex);
+        return db.upsertStudents(std::move(rows));
+    }
+
+    bool removeByEmail(const std::string& email) override {
+        std::unique_lock lock(mutex);
+        return db.removeByEmail(email);
+    }
+
+    bool isRemoved(size_t row) const override {
+        std::shared_lock lock(mutex);
+        return db.isRemoved(row);
+    }
+
+    size_t rowCount() const override {
+        std::shared_lock lock(mutex);
+        return db.rowCount();
+    }
+
+    StudentView getRow(size_t row) const override {
+        std::shared_lock lock(mutex);
+        return db.getRow(row);
+    }
+
+    size_t getMemoryUsage() const override {
+        std::shared_lock lock(mutex);
+        return db.getMemoryUsage();
+    }
+
+    const BloomFilter* getNameFilter() const override {
+        return db.getNameFilter();
+    }
+};
+
+// Variant 7: HashMap layout built for concurrent queries and updates
+//
+// After a load only the group of a row ever changes, so the row data, the
+// name and email indexes and the name filter are read without any lock.
+// Groups are interned strings that live until the next load; a row holds a
+// pointer to its group, guarded by one of STRIPES reader/writer locks
+// (row % STRIPES), so updates of different rows rarely contend and a
+// StudentView never dangles when its group is changed.
+// Loads are not concurrent: finish them before sharing the database.
+class ConcurrentDB : public IDatabase {
+private:
+    static constexpr size_t STRIPES = 64;
+
+    // One cache line per lock so neighbouring stripes do not false-share
+    struct alignas(64) Stripe {
+        std::shared_mutex mutex;
+    };
+
+    std::vector<Student> students;              // m_group moved into groupNames
+    std::vector<const std::string*> rowGroups;
+    std::unordered_map<std::string, std::vector<size_t>> nameIndex;
+    std::unordered_map<std::string, size_t> emailIndex;
+    std::vector<const std::vector<size_t>*> duplicateKeys;  // keys with 2+ rows
+    mutable std::array<Stripe, STRIPES> stripes;
+
+    std::unordered_set<std::string> groupNames;
+    mutable std::shared_mutex groupNamesMutex;
+
+    DatabaseOptions options;
+    DuplicateGroupTracker duplicates;
+    std::mutex duplicatesMutex;
+    BloomFilter nameFilter;
+    PerfectHashIndex perfectEmails;
+
+    std::string getNameKey(const std::string& name, const std::string& surname) const {
+        return name + "|" + surname;
+    }
+
+    std::shared_mutex& stripeOf(size_t row) const {
+        return stripes[row % STRIPES].mutex;
+    }
+
+    const std::string* groupOf(size_t row) const {
+        std::shared_lock lock(stripeOf(row));
+        return rowGroups[row];
+    }
+
+    const std::string* internGroup(const std::string& group) {
+        {
+            std::shared_lock lock(groupNamesMutex);
+            auto it = groupNames.find(group);
+            if (it != groupNames.end()) return &*it;
+        }
+        std::unique_lock lock(groupNamesMutex);
+        return &*groupNames.insert(group).first;
+    }
+
+    std::string_view emailOf(size_t row) const {
+        return students[row].m_email;
+    }
+
+    // Row of email, or NOT_FOUND
+    size_t findEmailRow(const std::string& email) const {
+        if (options.perfectEmailIndex) {
+            return findPerfectEmail(perfectEmails, email, [this](uint32_t row) { return emailOf(row); });
+        }
+        auto it = emailIndex.find(email);
+        return it == emailIndex.end() ? NOT_FOUND : it->second;
+    }
+
+    void clearIndexes() {
+        rowGroups.clear();
+        nameIndex.clear();
+        emailIndex.clear();
+        duplicateKeys.clear();
+        duplicates.clear();
+        groupNames.clear();
+        perfectEmails.clear();
+    }
+
+    // Moves the row's group into groupNames
+    void internRowGroup(Student& s) {
+        if (options.incrementalDuplicates) {
+            AllocationScope scope(AllocationTag::Other);
+            duplicates.add(getNameKey(s.m_name, s.m_surname), s.m_group);
+        }
+        rowGroups.push_back(internGroup(s.m_group));
+        std::string().swap(s.m_group);
+    }
+
+    // What needs every row: the keys with 2+ rows, the perfect email index, the name filter
+    void finishLoad() {
+        duplicateKeys.clear();
+        for (const auto& [key, indices] : nameIndex) {
+            if (indices.size() > 1) duplicateKeys.push_back(&indices);
+        }
+        perfectEmails.clear();
+        if (options.perfectEmailIndex) {
+            buildPerfectEmailIndex(perfectEmails, students.size(), [this](uint32_t row) { return emailOf(row); });
+        }
+        if (options.nameFilter) buildNameFilter(nameFilter);
+    }
+
+    // Builds every index over `students` with up to `threads` cores
+    void buildIndexes(size_t threads) {
+        clearIndexes();
+
+        {
+            AllocationScope rows(AllocationTag::Students);
+            rowGroups.reserve(students.size());
+            for (auto& s : students) {
+                internRowGroup(s);
+            }
+        }
+
+        {
+            AllocationScope scope(AllocationTag::NameIndex);
+            buildPartitionedIndex(nameIndex, students.size(), threads,
+                [&](size_t i) {
+                    std::hash<std::string> hash;
+                    return hash(students[i].m_name) * 31 + hash(students[i].m_surname);
+                },
+                [&](auto& index, size_t i) {
+                    index[getNameKey(students[i].m_name, students[i].m_surname)].push_back(i);
+                });
+        }
+        if (!options.perfectEmailIndex) {
+            AllocationScope scope(AllocationTag::EmailIndex);
+            emailIndex.reserve(students.size());
+            buildPartitionedIndex(emailIndex, students.size(), threads,
+                [&](size_t i) { return std::hash<std::string>()(students[i].m_email); },
+                [&](auto& index, size_t i) { index[students[i].m_email] = i; });
+        }
+        finishLoad();
+    }
+
+    // Streaming load: the row goes into both hash indexes as it arrives
+    void appendLoadedRow(Student&& s) {
+        size_t row = students.size();
+        {
+            AllocationScope rows(AllocationTag::Students);
+            internRowGroup(s);
+        }
+        {
+            AllocationScope scope(AllocationTag::NameIndex);
+            nameIndex[getNameKey(s.m_name, s.m_surname)].push_back(row);
+        }
+        if (!options.perfectEmailIndex) {
+            AllocationScope scope(AllocationTag::EmailIndex);
+            emailIndex[s.m_email] = row;
+        }
+        AllocationScope rows(AllocationTag::Students);
+        students.push_back(std::move(s));
+    }
+
+public:
+    explicit ConcurrentDB(DatabaseOptions options = {}) : options(options) {}
+
+    void loadFromFile(const std::string& filename) override {
+        CsvReader reader(filename);
+
+        beginLoad();
+        // Rows are parsed under Students, each insert is charged to its own structure
+        {
+            AllocationScope rows(AllocationTag::Students);
+            reader.forEachStudent([&](Student&& s) {
+                appendLoadedRow(std::move(s));
+            });
+        }
+        endLoad();
+    }
+
+    bool beginLoad() override {
+        students.clear();
+        clearIndexes();
+        return true;
+    }
+
+    void appendLoadedRows(std::vector<Student>& rows) override {
+        for (Student& s : rows) {
+            appendLoadedRow(std::move(s));
+        }
+        rows.clear();
+    }
+
+    void endLoad() override {
+        finishLoad();
+    }
+
+    void loadFromFileParallel(const std::string& filename, size_t threads) override {
+        CsvReader reader(filename);
+
+        {
+            AllocationScope scope(AllocationTag::Students);
+            students = reader.parseParallel(threads);
+        }
+        buildIndexes(threads);
+    }
+
+    bool saveSnapshot(const std::string& filename) const override {
+        SnapshotWriter writer;
+        for (size_t row = 0; row < students.size(); row++) {
+            writer.addStudent(getRow(row));
+        }
+        for (const auto& [key, indices] : nameIndex) {
+            writer.addNameEntry(indices);
+        }
+        perfectEmails.forEachValue([&](uint32_t row) { writer.addEmailRow(row); });
+        for (const auto& [email, idx] : emailIndex) {
+            writer.addEmailRow(idx);
+        }
+        return writer.write(filename);
+    }
+
+    bool loadSnapshot(const std::string& filename) override {
+        SnapshotReader reader(filename);
+        if (!reader.isValid()) return false;
+
+        {
+            AllocationScope scope(AllocationTag::Students);
+            students = reader.students();
+        }
+        buildIndexes(1);
+        return true;
+    }
+
+    RowSpan findRowsByNameSurname(const std::string& name, const std::string& surname,
+                                  std::vector<size_t>& scratch) const override {
+        if (options.nameFilter && !nameFilter.mayContain(hashKeyParts(name, surname))) return RowSpan();
+        auto it = nameIndex.find(getNameKey(name, surname));
+        if (it == nameIndex.end()) return RowSpan();
+        return RowSpan(it->second);
+    }
+
+    std::set<std::string> findGroupsWithDuplicateNameSurname() override {
+        if (options.incrementalDuplicates) {
+            std::lock_guard lock(duplicatesMutex);
+            return duplicates.groups();
+        }
+        // Interned groups compare by pointer; each row is read under its own stripe
+        std::set<const std::string*> marked;
+        std::vector<const std::string*> keyGroups;
+        for (const auto* indices : duplicateKeys) {
+            keyGroups.clear();
+            for (size_t idx : *indices) {
+                keyGroups.push_back(groupOf(idx));
+            }
+            bool distinct = false;
+            for (const auto* group : keyGroups) {
+                distinct |= group != keyGroups.front();
+            }
+            if (distinct) marked.insert(keyGroups.begin(), keyGroups.end());
+        }
+
+        std::set<std::string> result;
+        for (const auto* group : marked) {
+            result.insert(*group);
+        }
+        return result;
+    }
+
+    bool updateGroupByEmail(const std::string& email, const std::string& newGroup) override {
+        size_t row = findEmailRow(email);
+        if (row == NOT_FOUND) return false;
+
+        const std::string* group = internGroup(newGroup);
+        std::unique_lock lock(stripeOf(row));
+        if (options.incrementalDuplicates) {
+            // Still under the row's stripe, so the tracker sees this row's moves in order
+            std::lock_guard trackerLock(duplicatesMutex);
+            const Student& s = students[row];
+            duplicates.move(getNameKey(s.m_name, s.m_surname), *rowGroups[row], newGroup);
+        }
+        rowGroups[row] = group;
+        return true;
+    }
+
+    size_t rowCount() const override {
+        return students.size();
+    }
+
+    StudentView getRow(size_t row) const override {
+        StudentView s = students[row];
+        s.m_group = *groupOf(row);
+        return s;
+    }
+
+    size_t getMemoryUsage() const override {
+        size_t size = students.capacity() * sizeof(Student) + rowGroups.capacity() * sizeof(const std::string*);
+        for (const auto& [k, v] : nameIndex) {
+            size += k.capacity() + v.capacity() * sizeof(size_t);
+        }
+        for (const auto& [k, v] : emailIndex) {
+            size += k.capacity() + sizeof(size_t);
+        }
+        size += perfectEmails.getMemoryUsage();
+        for (const auto& group : groupNames) {
+            size += group.capacity();
+        }
+        size += duplicateKeys.capacity() * sizeof(void*) + sizeof(stripes);
+        if (options.incrementalDuplicates) {
+            size += duplicates.getMemoryUsage();
+        }
+        if (options.nameFilter) {
+            size += nameFilter.getMemoryUsage();
+        }
+        return size;
+    }
+
+    const BloomFilter* getNameFilter() const override {
+        return options.nameFilter ? &nameFilter : nullptr;
+    }
+};
+
+#endif
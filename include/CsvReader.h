@@ -0,0 +1,136 @@
+#ifndef CSV_READER_H
+#define CSV_READER_H
+
+#include "Student.h"
+#include "Parallel.h"
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only memory mapping of a whole CSV file.
+// Rows are handed out as string_views into the mapping, so loading does not
+// copy any line; line ends are found with memchr (vectorized in libc).
+class CsvReader {
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+
+public:
+    explicit CsvReader(const std::string& filename) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return;
+
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* mapped = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                ::madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+                data = static_cast<const char*>(mapped);
+                size = st.st_size;
+            }
+        }
+        ::close(fd);
+    }
+
+    ~CsvReader() {
+        if (data) {
+            ::munmap(const_cast<char*>(data), size);
+        }
+    }
+
+    CsvReader(const CsvReader&) = delete;
+    CsvReader& operator=(const CsvReader&) = delete;
+
+    std::string_view contents() const {
+        return std::string_view(data, size);
+    }
+
+    // Offset of the first data row: leading empty lines and the csv header are skipped
+    size_t dataOffset() const {
+        return dataOffsetIn(contents());
+    }
+
+    // Same for text holding the start of a file
+    static size_t dataOffsetIn(std::string_view text) {
+        size_t pos = text.find_first_not_of('\n');
+        if (pos == std::string_view::npos) return text.size();
+        if (text.compare(pos, 6, "m_name") != 0) return pos;
+        size_t newline = text.find('\n', pos);
+        return newline == std::string_view::npos ? text.size() : newline + 1;
+    }
+
+    // Calls fn(line) for every non-empty line of text
+    template <typename Fn>
+    static void forEachLineIn(std::string_view text, Fn&& fn) {
+        const char* pos = text.data();
+        const char* end = text.data() + text.size();
+
+        while (pos < end) {
+            const char* newline = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+            const char* lineEnd = newline ? newline : end;
+            std::string_view line(pos, lineEnd - pos);
+            pos = lineEnd + 1;
+
+            if (!line.empty()) fn(line);
+        }
+    }
+
+    // Calls fn(line) for every non-empty line, skipping the csv header
+    template <typename Fn>
+    void forEachLine(Fn&& fn) const {
+        forEachLineIn(contents().substr(dataOffset()), fn);
+    }
+
+    // Calls fn(Student&&) for every row of the file
+    template <typename Fn>
+    void forEachStudent(Fn&& fn) const {
+        forEachLine([&](std::string_view line) {
+            fn(Student::fromCSV(line));
+        });
+    }
+
+    // Parses all rows on `threads` workers. The data is cut into newline
+    // aligned chunks, each parsed into its own vector, and the results are
+    // moved into place so the order matches forEachStudent exactly.
+    std::vector<Student> parseParallel(size_t threads) const {
+        std::string_view text = contents().substr(dataOffset());
+        threads = std::max<size_t>(1, threads);
+
+        std::vector<std::string_view> chunks;
+        size_t begin = 0;
+        for (size_t t = 1; t <= threads && begin < text.size(); t++) {
+            size_t end = t == threads ? text.size() : std::max(begin, text.size() * t / threads);
+            end = text.find('\n', end);
+            end = end == std::string_view::npos ? text.size() : end + 1;
+            chunks.push_back(text.substr(begin, end - begin));
+            begin = end;
+        }
+
+        std::vector<std::vector<Student>> parts(chunks.size());
+        parallelFor(chunks.size(), [&](size_t t) {
+            forEachLineIn(chunks[t], [&](std::string_view line) {
+                parts[t].push_back(Student::fromCSV(line));
+            });
+        });
+
+        std::vector<size_t> offsets(parts.size() + 1, 0);
+        for (size_t t = 0; t < parts.size(); t++) {
+            offsets[t + 1] = offsets[t] + parts[t].size();
+        }
+
+        std::vector<Student> result(offsets.back());
+        parallelFor(parts.size(), [&](size_t t) {
+            std::move(parts[t].begin(), parts[t].end(), result.begin() + offsets[t]);
+            std::vector<Student>().swap(parts[t]);
+        });
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef CSV_WRITER_H
+#define CSV_WRITER_H
+
+#include "Student.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Buffered CSV output: rows are formatted straight into one reusable buffer
+// (StudentView::formatCSV, no stream or per-row string) and handed to the
+// kernel in large write() calls.
+class CsvWriter {
+private:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+    int fd = -1;
+    std::vector<char> buffer;
+    size_t used = 0;
+    bool failed = false;
+
+    // Makes room for `bytes` more bytes in the buffer
+    void reserve(size_t bytes) {
+        if (used + bytes > buffer.size()) {
+            flush();
+            if (bytes > buffer.size()) buffer.resize(bytes);
+        }
+    }
+
+public:
+    explicit CsvWriter(const std::string& filename, size_t bufferSize = DEFAULT_BUFFER_SIZE)
+        : buffer(bufferSize) {
+        fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        failed = fd < 0;
+    }
+
+    ~CsvWriter() {
+        close();
+    }
+
+    CsvWriter(const CsvWriter&) = delete;
+    CsvWriter& operator=(const CsvWriter&) = delete;
+
+    void writeStudent(const StudentView& s) {
+        reserve(s.csvSizeBound() + 1);
+        char* end = s.formatCSV(buffer.data() + used);
+        *end++ = '\n';
+        used = end - buffer.data();
+    }
+
+    // Writes line and a newline
+    void writeLine(std::string_view line) {
+        reserve(line.size() + 1);
+        std::memcpy(buffer.data() + used, line.data(), line.size());
+        used += line.size();
+        buffer[used++] = '\n';
+    }
+
+    void flush() {
+        const char* data = buffer.data();
+        while (used > 0 && !failed) {
+            ssize_t written = ::write(fd, data, used);
+            if (written <= 0) {
+                failed = true;
+                break;
+            }
+            data += written;
+            used -= written;
+        }
+        used = 0;
+    }
+
+    // Flushes and closes the file; false if any write failed
+    bool close() {
+        if (fd >= 0) {
+            flush();
+            failed |= ::close(fd) != 0;
+            fd = -1;
+        }
+        return !failed;
+    }
+};
+
+#endif
@@ -2,6 +2,15 @@
 #define DATABASE_H
 
 #include "Student.h"
+#include "DuplicateGroupTracker.h"
+#include "CsvReader.h"
+#include "Parallel.h"
+#include "AllocationCounter.h"
+#include "Snapshot.h"
+#include "BloomFilter.h"
+#include "KeyHash.h"
+#include "ScanKernel.h"
+#include "PerfectHashIndex.h"
 #include <vector>
 #include <unordered_map>
 #include <map>
@@ -10,244 +19,692 @@
 #include <algorithm>
 #include <memory>
 
+// Optional behaviour shared by all database variants
+struct DatabaseOptions {
+    // Maintain duplicate groups on load/update instead of rescanning per query
+    // (row-store variants: HashMap, Mixed, Map, FlatHash)
+    bool incrementalDuplicates = false;
+    // Answer name|surname lookups that cannot match from a Bloom filter
+    // rebuilt on every load, skipping the name index (or scan) for most misses
+    bool nameFilter = false;
+    // Replace the email index by a minimal perfect hash rebuilt on every load
+    // (emails never change between loads): a few bytes per email instead of
+    // a hash map node and a copy of the key
+    bool perfectEmailIndex = false;
+};
+
+// One operation 1 / operation 3 request of a batch
+struct NameQuery {
+    std::string name;
+    std::string surname;
+};
+
+struct GroupUpdate {
+    std::string email;
+    std::string newGroup;
+};
+
+// Row ids returned by a query, without copying any Student.
+// Points either into the database's own index or into a caller's scratch buffer.
+class RowSpan {
+private:
+    const size_t* rows = nullptr;
+    size_t count = 0;
+
+public:
+    RowSpan() = default;
+    RowSpan(const size_t* rows, size_t count) : rows(rows), count(count) {}
+    RowSpan(const std::vector<size_t>& rows) : rows(rows.data()), count(rows.size()) {}
+
+    const size_t* begin() const { return rows; }
+    const size_t* end() const { return rows + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t operator[](size_t i) const { return rows[i]; }
+};
+
 // Base interface for all database variants
+//
+// Lifetime rule for the non-copying API: a RowSpan from findRowsByNameSurname
+// and a StudentView from getRow stay valid until the next call that modifies
+// the database (any load, updateGroupByEmail, ...) and, for the span, until
+// the scratch vector passed to the query is reused or destroyed.
 class IDatabase {
 public:
     virtual ~IDatabase() = default;
     virtual void loadFromFile(const std::string& filename) = 0;
-    virtual std::vector<Student> findByNameSurname(const std::string& name, const std::string& surname) = 0;
+    // Same result as loadFromFile, using up to `threads` cores.
+    // Variants without a parallel path fall back to the serial loader.
+    virtual void loadFromFileParallel(const std::string& filename, size_t threads) {
+        loadFromFile(filename);
+    }
+    // Binary warm-start image of the loaded data and indexes (see Snapshot.h).
+    // Both return false when unsupported, on I/O errors or a corrupt file.
+    virtual bool saveSnapshot(const std::string& filename) const { return false; }
+    virtual bool loadSnapshot(const std::string& filename) { return false; }
+    virtual RowSpan findRowsByNameSurname(const std::string& name, const std::string& surname,
+                                          std::vector<size_t>& scratch) const = 0;
     virtual std::set<std::string> findGroupsWithDuplicateNameSurname() = 0;
     virtual bool updateGroupByEmail(const std::string& email, const std::string& newGroup) = 0;
-    virtual std::vector<Student> getAllStudents() const = 0;
+    virtual size_t rowCount() const = 0;
+    virtual StudentView getRow(size_t row) const = 0;
     virtual size_t getMemoryUsage() const = 0;
+    // Filter in front of the name index, nullptr unless DatabaseOptions::nameFilter is set
+    virtual const BloomFilter* getNameFilter() const { return nullptr; }
+
+    // Incremental ingestion, in time proportional to the rows given. A row
+    // whose email is already present replaces that row in place and keeps
+    // its id; any other row is appended. Of several rows with one email the
+    // last therefore wins. False when the variant does not support it.
+    virtual bool upsertStudents(std::vector<Student> rows) { return false; }
+    // Deletes every row carrying the email: the one it resolves to and any
+    // older rows a later one shadowed. Their ids stay taken by tombstones
+    // (see isRemoved) until the variant compacts its rows, which renumbers
+    // the rows after them. False if not found or unsupported.
+    virtual bool removeByEmail(const std::string& email) { return false; }
+    virtual bool isRemoved(size_t row) const { return false; }
+
+    // Streaming load, as driven by PipelinedLoader: beginLoad() empties the
+    // database, appendLoadedRows() adds rows in file order (and empties the
+    // vector), endLoad() builds what a load builds once at the end. Together
+    // they leave the same state as loadFromFile over the same rows. Variants
+    // that cannot load in steps return false from beginLoad.
+    virtual bool beginLoad() { return false; }
+    virtual void appendLoadedRows(std::vector<Student>& rows) {}
+    virtual void endLoad() {}
+
+    // Upserts every row of a CSV file
+    bool appendFromFile(const std::string& filename) {
+        CsvReader reader(filename);
+        std::vector<Student> rows;
+        reader.forEachStudent([&](Student&& s) {
+            rows.push_back(std::move(s));
+        });
+        return upsertStudents(std::move(rows));
+    }
+
+    // Batched operation 1: results[i] holds the rows of queries[i].
+    // Spans follow the findRowsByNameSurname lifetime rule, with scratch shared by the batch.
+    // Variants that can overlap the lookups' cache misses override these loops.
+    virtual void findRowsByNameSurnameBatch(const std::vector<NameQuery>& queries,
+                                            std::vector<RowSpan>& results, std::vector<size_t>& scratch) const {
+        std::vector<size_t> rows, ends;
+        scratch.clear();
+        for (const auto& q : queries) {
+            RowSpan found = findRowsByNameSurname(q.name, q.surname, rows);
+            scratch.insert(scratch.end(), found.begin(), found.end());
+            ends.push_back(scratch.size());
+        }
+        // scratch no longer grows, so the spans can point into it
+        results.clear();
+        for (size_t i = 0; i < ends.size(); i++) {
+            size_t begin = i == 0 ? 0 : ends[i - 1];
+            results.emplace_back(scratch.data() + begin, ends[i] - begin);
+        }
+    }
+
+    // Batched operation 3, applied in order; returns how many emails were found
+    virtual size_t updateGroupByEmailBatch(const std::vector<GroupUpdate>& updates) {
+        size_t updated = 0;
+        for (const auto& u : updates) {
+            updated += updateGroupByEmail(u.email, u.newGroup);
+        }
+        return updated;
+    }
+
+    // Copying wrappers over the row API
+    std::vector<Student> findByNameSurname(const std::string& name, const std::string& surname) const {
+        std::vector<size_t> scratch;
+        std::vector<Student> result;
+        for (size_t row : findRowsByNameSurname(name, surname, scratch)) {
+            result.push_back(getRow(row).toStudent());
+        }
+        return result;
+    }
+
+    std::vector<Student> getAllStudents() const {
+        std::vector<Student> result;
+        result.reserve(rowCount());
+        for (size_t row = 0; row < rowCount(); row++) {
+            if (!isRemoved(row)) result.push_back(getRow(row).toStudent());
+        }
+        return result;
+    }
+
+protected:
+    // Requests resolved together by the batched overrides: enough to keep
+    // many misses in flight while the prefetched lines still fit in L1
+    static constexpr size_t BATCH_WINDOW = 32;
+    static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+    // Rebuilds index over the email of every row; emailOf(row) returns it
+    template <typename EmailOf>
+    static void buildPerfectEmailIndex(PerfectHashIndex& index, size_t rows, EmailOf emailOf) {
+        AllocationScope scope(AllocationTag::EmailIndex);
+        index.build(rows, [&](uint32_t row) { return hashKeyParts(emailOf(row)); },
+                    [&](uint32_t a, uint32_t b) { return emailOf(a) == emailOf(b); });
+    }
+
+    // Row of email in index, or NOT_FOUND
+    template <typename EmailOf>
+    static size_t findPerfectEmail(const PerfectHashIndex& index, std::string_view email, EmailOf emailOf) {
+        const uint32_t* row = index.find(hashKeyParts(email), [&](uint32_t row) { return emailOf(row) == email; });
+        return row ? *row : NOT_FOUND;
+    }
+
+    // Older rows whose email a later row took over at load, by email
+    using ShadowedRows = std::unordered_map<std::string, std::vector<size_t>>;
+
+    // Refills shadowed with the rows no email index entry points to;
+    // forEachIndexed(fn) calls fn(row) for every row the index holds.
+    // removeByEmail tombstones them with the row that shadows them, so no
+    // rebuild of the index can bring a removed email back.
+    template <typename ForEachIndexed>
+    void collectShadowedRows(ShadowedRows& shadowed, ForEachIndexed forEachIndexed) const {
+        shadowed.clear();
+        std::vector<bool> indexed(rowCount(), false);
+        forEachIndexed([&](size_t row) { indexed[row] = true; });
+        AllocationScope scope(AllocationTag::EmailIndex);
+        for (size_t row = 0; row < rowCount(); row++) {
+            if (!indexed[row]) shadowed[std::string(getRow(row).m_email)].push_back(row);
+        }
+    }
+
+    // Refills filter with the name|surname of every row
+    void buildNameFilter(BloomFilter& filter) const {
+        filter.reset(rowCount());
+        for (size_t row = 0; row < rowCount(); row++) {
+            StudentView s = getRow(row);
+            filter.add(hashKeyParts(s.m_name, s.m_surname));
+        }
+    }
 };
 
-// Variant 1: Hash map based lookup
-class HashMapDB : public IDatabase {
-private:
+// Rows kept as a std::vector<Student>, with the email index, duplicate
+// groups, name filter and incremental ingestion shared by Variants 1-3.
+// Removed rows become tombstones, dropped from every index at once and from
+// the row vector by a compaction once they make up 1/COMPACT_DIVISOR of the
+// rows. Subclasses own the name lookup and keep it in step through the hooks.
+class RowStoreDB : public IDatabase {
+protected:
     std::vector<Student> students;
-    std::unordered_map<std::string, std::vector<size_t>> nameIndex;
     std::unordered_map<std::string, size_t> emailIndex;
+    DatabaseOptions options;
+    DuplicateGroupTracker duplicates;
+    BloomFilter nameFilter;
+    PerfectHashIndex perfectEmails;
+    std::vector<bool> removed;      // tombstones, one per row
+    size_t removedCount = 0;
+    size_t filterRows = 0;          // rows the name filter was sized for
+    ShadowedRows shadowedRows;
+
+    static constexpr size_t COMPACT_DIVISOR = 4;
 
-    std::string getNameKey(const std::string& name, const std::string& surname) const {
+    explicit RowStoreDB(DatabaseOptions options) : options(options) {}
+
+    static std::string getNameKey(const std::string& name, const std::string& surname) {
         return name + "|" + surname;
     }
 
-public:
-    void loadFromFile(const std::string& filename) override {
-        std::ifstream file(filename);
-        std::string line;
-        
-        students.clear();
-        nameIndex.clear();
-        emailIndex.clear();
-        
-        bool firstLine = true;
-        while (std::getline(file, line)) {
-            if (line.empty()) continue;
-            // Skip header of csv
-            if (firstLine && line.find("m_name") == 0) {
-                firstLine = false;
-                continue;
+    // Name lookup hooks. Loads call clearNames first, then indexLoadedRow per
+    // streamed row, indexLoadedRows once after a parallel parse or
+    // loadNameEntries after a snapshot, and finishNames last, over rows
+    // without tombstones. Between loads every row change is reported before
+    // the row itself changes.
+    virtual void clearNames() {}
+    virtual void indexLoadedRow(size_t row) {}
+    virtual void indexLoadedRows(size_t threads) {}
+    virtual void loadNameEntries(const SnapshotReader& reader) {}
+    virtual void saveNameEntries(SnapshotWriter& writer, const std::vector<size_t>& newIds) const {}
+    virtual void finishNames(size_t threads) {}
+    virtual void addRowName(size_t row) = 0;
+    virtual void renameRow(size_t row, const Student& old, const Student& updated) = 0;
+    virtual void removeRowName(size_t row) = 0;
+    // Rows moved to newIds[row] by a compaction, removed rows to NOT_FOUND
+    virtual void remapRows(const std::vector<size_t>& newIds) {}
+    virtual size_t namesMemoryUsage() const = 0;
+
+    std::string_view emailOf(size_t row) const {
+        return students[row].m_email;
+    }
+
+    // Row of email, or NOT_FOUND. With the perfect index, emails upserted
+    // since the last load or compaction are in emailIndex, and rows removed
+    // since then are still in the perfect index, masked by their tombstone.
+    size_t findEmailRow(const std::string& email) const {
+        if (options.perfectEmailIndex) {
+            if (!emailIndex.empty()) {
+                auto it = emailIndex.find(email);
+                if (it != emailIndex.end()) return it->second;
             }
-            firstLine = false;
-            
-            Student s = Student::fromCSV(line);
-            size_t idx = students.size();
-            students.push_back(s);
-            
-            std::string key = getNameKey(s.m_name, s.m_surname);
-            nameIndex[key].push_back(idx);
-            emailIndex[s.m_email] = idx;
+            size_t row = findPerfectEmail(perfectEmails, email, [this](uint32_t row) { return emailOf(row); });
+            return row != NOT_FOUND && removed[row] ? NOT_FOUND : row;
         }
+        auto it = emailIndex.find(email);
+        return it == emailIndex.end() ? NOT_FOUND : it->second;
     }
 
-    std::vector<Student> findByNameSurname(const std::string& name, const std::string& surname) override {
-        std::vector<Student> result;
-        std::string key = getNameKey(name, surname);
-        auto it = nameIndex.find(key);
-        if (it != nameIndex.end()) {
-            for (size_t idx : it->second) {
-                result.push_back(students[idx]);
+    void buildPerfectEmails() {
+        perfectEmails.clear();
+        if (options.perfectEmailIndex) {
+            buildPerfectEmailIndex(perfectEmails, students.size(), [this](uint32_t row) { return emailOf(row); });
+        }
+    }
+
+    // Last step of every load and compaction, over rows without tombstones
+    void finishLoad(size_t threads) {
+        removed.assign(students.size(), false);
+        removedCount = 0;
+        {
+            AllocationScope scope(AllocationTag::NameIndex);
+            finishNames(threads);
+        }
+        buildPerfectEmails();
+        collectShadowedRows(shadowedRows, [this](auto mark) {
+            if (options.perfectEmailIndex) {
+                perfectEmails.forEachValue(mark);
+            } else {
+                for (const auto& [email, row] : emailIndex) mark(row);
             }
+        });
+        if (options.nameFilter) {
+            buildNameFilter(nameFilter);
+            filterRows = students.size();
         }
-        return result;
     }
 
-    std::set<std::string> findGroupsWithDuplicateNameSurname() override {
-        std::set<std::string> result;
-        for (const auto& [key, indices] : nameIndex) {
-            if (indices.size() > 1) {
-                std::set<std::string> groups;
-                for (size_t idx : indices) {
-                    groups.insert(students[idx].m_group);
-                }
-                if (groups.size() > 1) {
-                    result.insert(groups.begin(), groups.end());
-                }
+    void addDuplicates() {
+        if (options.incrementalDuplicates) {
+            for (const auto& row : students) {
+                duplicates.add(getNameKey(row.m_name, row.m_surname), row.m_group);
             }
         }
-        return result;
     }
 
-    bool updateGroupByEmail(const std::string& email, const std::string& newGroup) override {
-        auto it = emailIndex.find(email);
-        if (it != emailIndex.end()) {
-            students[it->second].m_group = newGroup;
-            return true;
+    void removeRow(size_t row) {
+        const Student& s = students[row];
+        if (options.incrementalDuplicates) {
+            duplicates.remove(getNameKey(s.m_name, s.m_surname), s.m_group);
         }
-        return false;
+        removeRowName(row);
+        removed[row] = true;
+        removedCount++;
+    }
+
+    void upsertRow(Student&& s) {
+        size_t row = findEmailRow(s.m_email);
+        if (row != NOT_FOUND) {
+            Student& old = students[row];
+            if (options.incrementalDuplicates) {
+                AllocationScope scope(AllocationTag::Other);
+                duplicates.remove(getNameKey(old.m_name, old.m_surname), old.m_group);
+                duplicates.add(getNameKey(s.m_name, s.m_surname), s.m_group);
+            }
+            if (old.m_name != s.m_name || old.m_surname != s.m_surname) {
+                AllocationScope scope(AllocationTag::NameIndex);
+                renameRow(row, old, s);
+                if (options.nameFilter) nameFilter.add(hashKeyParts(s.m_name, s.m_surname));
+            }
+            AllocationScope scope(AllocationTag::Students);
+            old = std::move(s);
+            return;
+        }
+
+        row = students.size();
+        {
+            AllocationScope scope(AllocationTag::Students);
+            students.push_back(std::move(s));
+            removed.push_back(false);
+        }
+        const Student& added = students[row];
+        if (options.incrementalDuplicates) {
+            AllocationScope scope(AllocationTag::Other);
+            duplicates.add(getNameKey(added.m_name, added.m_surname), added.m_group);
+        }
+        {
+            AllocationScope scope(AllocationTag::NameIndex);
+            addRowName(row);
+        }
+        {
+            AllocationScope scope(AllocationTag::EmailIndex);
+            emailIndex[added.m_email] = row;
+        }
+        if (options.nameFilter) nameFilter.add(hashKeyParts(added.m_name, added.m_surname));
     }
 
-    std::vector<Student> getAllStudents() const override {
-        return students;
+    // New id of every row once the tombstones are gone, NOT_FOUND for removed rows
+    std::vector<size_t> liveRowIds() const {
+        std::vector<size_t> newIds(students.size(), NOT_FOUND);
+        size_t live = 0;
+        for (size_t row = 0; row < students.size(); row++) {
+            if (!removed[row]) newIds[row] = live++;
+        }
+        return newIds;
     }
 
-    size_t getMemoryUsage() const override {
-        size_t size = students.capacity() * sizeof(Student);
-        for (const auto& [k, v] : nameIndex) {
-            size += k.capacity() + v.capacity() * sizeof(size_t);
+    // Live rows move down in order, so postings stay sorted. The email index
+    // is rebuilt rather than remapped, so both kinds of it agree afterwards.
+    void compact() {
+        std::vector<size_t> newIds = liveRowIds();
+        size_t live = 0;
+        for (size_t row = 0; row < students.size(); row++) {
+            if (newIds[row] == NOT_FOUND) continue;
+            if (live != row) students[live] = std::move(students[row]);
+            live++;
         }
-        for (const auto& [k, v] : emailIndex) {
-            size += k.capacity() + sizeof(size_t);
+        students.resize(live);
+        remapRows(newIds);
+        emailIndex.clear();
+        if (!options.perfectEmailIndex) {
+            AllocationScope scope(AllocationTag::EmailIndex);
+            for (size_t row = 0; row < students.size(); row++) {
+                emailIndex[students[row].m_email] = row;
+            }
         }
-        return size;
+        finishLoad(1);
     }
-};
 
-// Variant 2: Mixed approach (hash for emails + vector search for names)
-class MixedDB : public IDatabase {
-private:
-    std::vector<Student> students;
-    std::unordered_map<std::string, size_t> emailIndex;
+    // One row of a load, in file order
+    void appendLoadedRow(Student&& s) {
+        size_t idx = students.size();
+        students.push_back(std::move(s));
+        const Student& row = students[idx];
+        if (options.incrementalDuplicates) {
+            AllocationScope scope(AllocationTag::Other);
+            duplicates.add(getNameKey(row.m_name, row.m_surname), row.m_group);
+        }
+        {
+            AllocationScope scope(AllocationTag::NameIndex);
+            indexLoadedRow(idx);
+        }
+        if (!options.perfectEmailIndex) {
+            AllocationScope scope(AllocationTag::EmailIndex);
+            emailIndex[row.m_email] = idx;
+        }
+    }
 
 public:
     void loadFromFile(const std::string& filename) override {
-        std::ifstream file(filename);
-        std::string line;
-        
+        CsvReader reader(filename);
+
+        beginLoad();
+        // Rows are parsed under Students, each insert is charged to its own structure
+        {
+            AllocationScope rows(AllocationTag::Students);
+            reader.forEachStudent([&](Student&& s) {
+                appendLoadedRow(std::move(s));
+            });
+        }
+        endLoad();
+    }
+
+    bool beginLoad() override {
         students.clear();
+        clearNames();
         emailIndex.clear();
-        
-        bool firstLine = true;
-        while (std::getline(file, line)) {
-            if (line.empty()) continue;
-            // Skip header of csv
-            if (firstLine && line.find("m_name") == 0) {
-                firstLine = false;
-                continue;
-            }
-            firstLine = false;
-            
-            Student s = Student::fromCSV(line);
-            size_t idx = students.size();
-            students.push_back(s);
-            emailIndex[s.m_email] = idx;
+        duplicates.clear();
+        return true;
+    }
+
+    void appendLoadedRows(std::vector<Student>& rows) override {
+        AllocationScope scope(AllocationTag::Students);
+        for (Student& s : rows) {
+            appendLoadedRow(std::move(s));
         }
+        rows.clear();
     }
 
-    std::vector<Student> findByNameSurname(const std::string& name, const std::string& surname) override {
-        std::vector<Student> result;
-        for (const auto& s : students) {
-            if (s.m_name == name && s.m_surname == surname) {
-                result.push_back(s);
-            }
+    void endLoad() override {
+        finishLoad(1);
+    }
+
+    void loadFromFileParallel(const std::string& filename, size_t threads) override {
+        CsvReader reader(filename);
+
+        clearNames();
+        emailIndex.clear();
+        duplicates.clear();
+
+        {
+            AllocationScope scope(AllocationTag::Students);
+            students = reader.parseParallel(threads);
         }
-        return result;
+
+        {
+            AllocationScope scope(AllocationTag::NameIndex);
+            indexLoadedRows(threads);
+        }
+        if (!options.perfectEmailIndex) {
+            AllocationScope scope(AllocationTag::EmailIndex);
+            emailIndex.reserve(students.size());
+            buildPartitionedIndex(emailIndex, students.size(), threads,
+                [&](size_t i) { return std::hash<std::string>()(students[i].m_email); },
+                [&](auto& index, size_t i) { index[students[i].m_email] = i; });
+        }
+
+        addDuplicates();
+        finishLoad(std::max<size_t>(1, threads));
     }
 
-    std::set<std::string> findGroupsWithDuplicateNameSurname() override {
-        std::set<std::string> result;
-        std::map<std::string, std::set<std::string>> nameToGroups;
-        
-        for (const auto& s : students) {
-            std::string key = s.m_name + "|" + s.m_surname;
-            nameToGroups[key].insert(s.m_group);
-        }
-        
-        for (const auto& [key, groups] : nameToGroups) {
-            if (groups.size() > 1) {
-                result.insert(groups.begin(), groups.end());
+    // Tombstones are left out, with the ids compact() would give
+    bool saveSnapshot(const std::string& filename) const override {
+        std::vector<size_t> newIds = liveRowIds();
+        SnapshotWriter writer;
+        for (size_t row = 0; row < students.size(); row++) {
+            if (!removed[row]) writer.addStudent(students[row]);
+        }
+        saveNameEntries(writer, newIds);
+        perfectEmails.forEachValue([&](uint32_t row) {
+            if (!removed[row]) writer.addEmailRow(newIds[row]);
+        });
+        for (const auto& [email, idx] : emailIndex) {
+            writer.addEmailRow(newIds[idx]);
+        }
+        return writer.write(filename);
+    }
+
+    bool loadSnapshot(const std::string& filename) override {
+        SnapshotReader reader(filename);
+        if (!reader.isValid()) return false;
+
+        {
+            AllocationScope scope(AllocationTag::Students);
+            students = reader.students();
+        }
+        clearNames();
+        emailIndex.clear();
+        duplicates.clear();
+
+        {
+            AllocationScope scope(AllocationTag::NameIndex);
+            loadNameEntries(reader);
+        }
+
+        if (!options.perfectEmailIndex) {
+            AllocationScope scope(AllocationTag::EmailIndex);
+            emailIndex.reserve(reader.emailEntryCount());
+            for (size_t i = 0; i < reader.emailEntryCount(); i++) {
+                size_t row = reader.emailRow(i);
+                emailIndex.emplace(students[row].m_email, row);
             }
         }
-        return result;
+
+        addDuplicates();
+        finishLoad(1);
+        return true;
     }
 
     bool updateGroupByEmail(const std::string& email, const std::string& newGroup) override {
-        auto it = emailIndex.find(email);
-        if (it != emailIndex.end()) {
-            students[it->second].m_group = newGroup;
+        size_t row = findEmailRow(email);
+        if (row != NOT_FOUND) {
+            Student& s = students[row];
+            if (options.incrementalDuplicates) {
+                duplicates.move(getNameKey(s.m_name, s.m_surname), s.m_group, newGroup);
+            }
+            s.m_group = newGroup;
             return true;
         }
         return false;
     }
 
-    std::vector<Student> getAllStudents() const override {
-        return students;
+    bool upsertStudents(std::vector<Student> rows) override {
+        for (Student& s : rows) {
+            upsertRow(std::move(s));
+        }
+        // Keep the filter near its bits per key as rows are added
+        if (options.nameFilter && nameFilter.size() > 2 * filterRows) {
+            buildNameFilter(nameFilter);
+            filterRows = students.size();
+        }
+        return true;
+    }
+
+    bool removeByEmail(const std::string& email) override {
+        size_t row = findEmailRow(email);
+        if (row == NOT_FOUND) return false;
+
+        auto shadowed = shadowedRows.find(email);
+        if (shadowed != shadowedRows.end()) {
+            for (size_t older : shadowed->second) removeRow(older);
+            shadowedRows.erase(shadowed);
+        }
+        removeRow(row);
+        emailIndex.erase(email);
+        if (removedCount * COMPACT_DIVISOR >= students.size()) compact();
+        return true;
+    }
+
+    bool isRemoved(size_t row) const override {
+        return removed[row];
+    }
+
+    size_t rowCount() const override {
+        return students.size();
+    }
+
+    StudentView getRow(size_t row) const override {
+        return students[row];
     }
 
     size_t getMemoryUsage() const override {
-        size_t size = students.capacity() * sizeof(Student);
+        size_t size = students.capacity() * sizeof(Student) + namesMemoryUsage();
         for (const auto& [k, v] : emailIndex) {
             size += k.capacity() + sizeof(size_t);
         }
+        for (const auto& [k, v] : shadowedRows) {
+            size += k.capacity() + v.capacity() * sizeof(size_t);
+        }
+        size += perfectEmails.getMemoryUsage() + removed.capacity() / 8;
+        if (options.incrementalDuplicates) {
+            size += duplicates.getMemoryUsage();
+        }
+        if (options.nameFilter) {
+            size += nameFilter.getMemoryUsage();
+        }
         return size;
     }
+
+    const BloomFilter* getNameFilter() const override {
+        return options.nameFilter ? &nameFilter : nullptr;
+    }
 };
 
-// Variant 3: Map-based (BST approach)
-class MapDB : public IDatabase {
-private:
-    std::vector<Student> students;
-    std::map<std::string, std::vector<size_t>> nameIndex;
-    std::unordered_map<std::string, size_t> emailIndex;
+// Name lookup through sorted postings by name|surname, in NameIndex
+// (std::unordered_map for Variant 1, std::map for Variant 3)
+template <typename NameIndex>
+class PostingIndexDB : public RowStoreDB {
+protected:
+    NameIndex nameIndex;
 
-    std::string getNameKey(const std::string& name, const std::string& surname) const {
-        return name + "|" + surname;
+    void removePosting(const std::string& key, size_t row) {
+        auto it = nameIndex.find(key);
+        if (it == nameIndex.end()) return;
+        std::vector<size_t>& rows = it->second;
+        auto pos = std::lower_bound(rows.begin(), rows.end(), row);
+        if (pos != rows.end() && *pos == row) rows.erase(pos);
+        if (rows.empty()) nameIndex.erase(it);
     }
 
-public:
-    void loadFromFile(const std::string& filename) override {
-        std::ifstream file(filename);
-        std::string line;
-        
-        students.clear();
+    void clearNames() override {
         nameIndex.clear();
-        emailIndex.clear();
-        
-        bool firstLine = true;
-        while (std::getline(file, line)) {
-            if (line.empty()) continue;
-            // Skip header if it starts with "m_name"
-            if (firstLine && line.find("m_name") == 0) {
-                firstLine = false;
-                continue;
-            }
-            firstLine = false;
-            
-            Student s = Student::fromCSV(line);
-            size_t idx = students.size();
-            students.push_back(s);
-            
-            std::string key = getNameKey(s.m_name, s.m_surname);
-            nameIndex[key].push_back(idx);
-            emailIndex[s.m_email] = idx;
+    }
+
+    void indexLoadedRow(size_t row) override {
+        nameIndex[getNameKey(students[row].m_name, students[row].m_surname)].push_back(row);
+    }
+
+    void indexLoadedRows(size_t threads) override {
+        buildPartitionedIndex(nameIndex, students.size(), threads,
+            [&](size_t i) {
+                std::hash<std::string> hash;
+                return hash(students[i].m_name) * 31 + hash(students[i].m_surname);
+            },
+            [&](auto& index, size_t i) {
+                index[getNameKey(students[i].m_name, students[i].m_surname)].push_back(i);
+            });
+    }
+
+    // A MapDB snapshot has its entries in key order, so every std::map insert lands at the end
+    void loadNameEntries(const SnapshotReader& reader) override {
+        for (size_t i = 0; i < reader.nameEntryCount(); i++) {
+            const Student& first = students[*reader.namePostingsBegin(i)];
+            nameIndex.emplace_hint(nameIndex.end(), getNameKey(first.m_name, first.m_surname),
+                std::vector<size_t>(reader.namePostingsBegin(i), reader.namePostingsEnd(i)));
         }
     }
 
-    std::vector<Student> findByNameSurname(const std::string& name, const std::string& surname) override {
-        std::vector<Student> result;
-        std::string key = getNameKey(name, surname);
-        auto it = nameIndex.find(key);
-        if (it != nameIndex.end()) {
-            for (size_t idx : it->second) {
-                result.push_back(students[idx]);
-            }
+    void saveNameEntries(SnapshotWriter& writer, const std::vector<size_t>& newIds) const override {
+        std::vector<size_t> rows;
+        for (const auto& [key, indices] : nameIndex) {
+            rows.clear();
+            for (size_t idx : indices) rows.push_back(newIds[idx]);
+            writer.addNameEntry(rows);
         }
-        return result;
+    }
+
+    void addRowName(size_t row) override {
+        nameIndex[getNameKey(students[row].m_name, students[row].m_surname)].push_back(row);
+    }
+
+    void renameRow(size_t row, const Student& old, const Student& updated) override {
+        removePosting(getNameKey(old.m_name, old.m_surname), row);
+        std::vector<size_t>& rows = nameIndex[getNameKey(updated.m_name, updated.m_surname)];
+        rows.insert(std::lower_bound(rows.begin(), rows.end(), row), row);
+    }
+
+    void removeRowName(size_t row) override {
+        removePosting(getNameKey(students[row].m_name, students[row].m_surname), row);
+    }
+
+    void remapRows(const std::vector<size_t>& newIds) override {
+        for (auto& [key, rows] : nameIndex) {
+            for (size_t& row : rows) row = newIds[row];
+        }
+    }
+
+    size_t namesMemoryUsage() const override {
+        size_t size = 0;
+        for (const auto& [k, v] : nameIndex) {
+            size += k.capacity() + v.capacity() * sizeof(size_t);
+        }
+        return size;
+    }
+
+public:
+    explicit PostingIndexDB(DatabaseOptions options) : RowStoreDB(options) {}
+
+    RowSpan findRowsByNameSurname(const std::string& name, const std::string& surname,
+                                  std::vector<size_t>& scratch) const override {
+        if (options.nameFilter && !nameFilter.mayContain(hashKeyParts(name, surname))) return RowSpan();
+        auto it = nameIndex.find(getNameKey(name, surname));
+        if (it == nameIndex.end()) return RowSpan();
+        return RowSpan(it->second);
     }
 
     std::set<std::string> findGroupsWithDuplicateNameSurname() override {
+        if (options.incrementalDuplicates) {
+            return duplicates.groups();
+        }
         std::set<std::string> result;
         for (const auto& [key, indices] : nameIndex) {
             if (indices.size() > 1) {
@@ -262,31 +719,203 @@ public:
         }
         return result;
     }
+};
 
-    bool updateGroupByEmail(const std::string& email, const std::string& newGroup) override {
-        auto it = emailIndex.find(email);
-        if (it != emailIndex.end()) {
-            students[it->second].m_group = newGroup;
-            return true;
+// Variant 1: Hash map based lookup
+class HashMapDB : public PostingIndexDB<std::unordered_map<std::string, std::vector<size_t>>> {
+protected:
+    void loadNameEntries(const SnapshotReader& reader) override {
+        nameIndex.reserve(reader.nameEntryCount());
+        PostingIndexDB::loadNameEntries(reader);
+    }
+
+public:
+    explicit HashMapDB(DatabaseOptions options = {}) : PostingIndexDB(options) {}
+
+    // Spans point into the index, so unlike the default nothing is copied
+    void findRowsByNameSurnameBatch(const std::vector<NameQuery>& queries,
+                                    std::vector<RowSpan>& results, std::vector<size_t>& scratch) const override {
+        results.resize(queries.size());
+        for (size_t i = 0; i < queries.size(); i++) {
+            results[i] = findRowsByNameSurname(queries[i].name, queries[i].surname, scratch);
         }
-        return false;
     }
 
-    std::vector<Student> getAllStudents() const override {
-        return students;
+    size_t updateGroupByEmailBatch(const std::vector<GroupUpdate>& updates) override {
+        size_t updated = 0;
+        size_t targets[BATCH_WINDOW];
+        for (size_t begin = 0; begin < updates.size(); begin += BATCH_WINDOW) {
+            size_t end = std::min(updates.size(), begin + BATCH_WINDOW);
+            // Resolve the window's emails and prefetch the rows before writing any of them
+            for (size_t i = begin; i < end; i++) {
+                targets[i - begin] = findEmailRow(updates[i].email);
+                if (targets[i - begin] != NOT_FOUND) {
+                    __builtin_prefetch(&students[targets[i - begin]].m_group, 1);
+                }
+            }
+            for (size_t i = begin; i < end; i++) {
+                if (targets[i - begin] == NOT_FOUND) continue;
+                Student& s = students[targets[i - begin]];
+                if (options.incrementalDuplicates) {
+                    duplicates.move(getNameKey(s.m_name, s.m_surname), s.m_group, updates[i].newGroup);
+                }
+                s.m_group = updates[i].newGroup;
+                updated++;
+            }
+        }
+        return updated;
+    }
+};
+
+// Variant 2: Mixed approach (hash for emails + vector search for names)
+// Names have no index. Lookups scan a packed column with a 32-bit hash of
+// name|surname per row using the widest SIMD kernel the CPU has, and compare
+// strings only on hash hits. The rows of every name that occurs more than
+// once are grouped into runs up front and duplicate detection only rereads
+// their groups. Removed rows stay in the scan column behind a tombstone, and
+// upserts that add rows or change names leave the runs to be rebuilt by the
+// next duplicate query.
+class MixedDB : public RowStoreDB {
+private:
+    static constexpr size_t SCAN_BLOCK = 1024;
+
+    std::vector<uint32_t> nameHashes;
+    std::vector<uint32_t> runRows;     // rows of repeated names, one name after another
+    std::vector<uint32_t> runEnds;     // end of each name's rows in runRows
+    ScanKernel scanKernel = selectScanKernel();
+    bool runsStale = false;         // rows or names changed since the runs were built
+
+    static uint32_t scanValue(uint64_t hash) {
+        return static_cast<uint32_t>(hash >> 32);
     }
 
-    size_t getMemoryUsage() const override {
-        size_t size = students.capacity() * sizeof(Student);
-        for (const auto& [k, v] : nameIndex) {
-            // 32 is BSD overhead
-            size += k.capacity() + v.capacity() * sizeof(size_t) + 32;
+    // Fills the hash column and the duplicate runs; hashes are computed on `threads` cores
+    void buildScanColumns(size_t threads) {
+        AllocationScope scope(AllocationTag::NameIndex);
+        size_t rows = students.size();
+        nameHashes.resize(rows);
+        parallelFor(threads, [&](size_t t) {
+            for (size_t i = rows * t / threads; i < rows * (t + 1) / threads; i++) {
+                nameHashes[i] = scanValue(hashKeyParts(students[i].m_name, students[i].m_surname));
+            }
+        });
+        buildRuns();
+    }
+
+    // Groups the live rows of every repeated name into runs
+    void buildRuns() {
+        AllocationScope scope(AllocationTag::NameIndex);
+        std::vector<uint32_t> order;
+        order.reserve(students.size());
+        for (size_t i = 0; i < students.size(); i++) {
+            if (!removed[i]) order.push_back(static_cast<uint32_t>(i));
         }
-        for (const auto& [k, v] : emailIndex) {
-            size += k.capacity() + sizeof(size_t);
+        size_t rows = order.size();
+        auto sameName = [&](uint32_t a, uint32_t b) {
+            return nameHashes[a] == nameHashes[b] &&
+                   students[a].m_name == students[b].m_name && students[a].m_surname == students[b].m_surname;
+        };
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            if (nameHashes[a] != nameHashes[b]) return nameHashes[a] < nameHashes[b];
+            if (students[a].m_name != students[b].m_name) return students[a].m_name < students[b].m_name;
+            if (students[a].m_surname != students[b].m_surname) return students[a].m_surname < students[b].m_surname;
+            return a < b;
+        });
+
+        runRows.clear();
+        runEnds.clear();
+        for (size_t begin = 0, end; begin < rows; begin = end) {
+            for (end = begin + 1; end < rows && sameName(order[begin], order[end]); end++) {}
+            if (end - begin > 1) {
+                runRows.insert(runRows.end(), order.begin() + begin, order.begin() + end);
+                runEnds.push_back(static_cast<uint32_t>(runRows.size()));
+            }
         }
-        return size;
+        runsStale = false;
     }
+
+    // The scan column is built once per load or compaction, over every row
+    void finishNames(size_t threads) override {
+        buildScanColumns(threads);
+    }
+
+    void addRowName(size_t row) override {
+        nameHashes.push_back(scanValue(hashKeyParts(students[row].m_name, students[row].m_surname)));
+        runsStale = true;
+    }
+
+    // A changed name only rewrites the row's hash; the runs are rebuilt
+    // lazily by the next duplicate query that reads them
+    void renameRow(size_t row, const Student& old, const Student& updated) override {
+        nameHashes[row] = scanValue(hashKeyParts(updated.m_name, updated.m_surname));
+        runsStale = true;
+    }
+
+    // The row stays in the scan column; lookups skip it by its tombstone
+    void removeRowName(size_t row) override {
+        runsStale = true;
+    }
+
+    size_t namesMemoryUsage() const override {
+        return (nameHashes.capacity() + runRows.capacity() + runEnds.capacity()) * sizeof(uint32_t);
+    }
+
+public:
+    explicit MixedDB(DatabaseOptions options = {}) : RowStoreDB(options) {}
+
+    RowSpan findRowsByNameSurname(const std::string& name, const std::string& surname,
+                                  std::vector<size_t>& scratch) const override {
+        uint64_t hash = hashKeyParts(name, surname);
+        if (options.nameFilter && !nameFilter.mayContain(hash)) return RowSpan();
+        scratch.clear();
+        uint32_t matches[SCAN_BLOCK];
+        for (size_t begin = 0; begin < nameHashes.size(); begin += SCAN_BLOCK) {
+            size_t count = std::min(SCAN_BLOCK, nameHashes.size() - begin);
+            size_t found = scanKernel(nameHashes.data() + begin, count, scanValue(hash), matches);
+            for (size_t i = 0; i < found; i++) {
+                size_t idx = begin + matches[i];
+                if (!removed[idx] && students[idx].m_name == name && students[idx].m_surname == surname) {
+                    scratch.push_back(idx);
+                }
+            }
+        }
+        return RowSpan(scratch);
+    }
+
+    std::set<std::string> findGroupsWithDuplicateNameSurname() override {
+        if (options.incrementalDuplicates) {
+            return duplicates.groups();
+        }
+        if (runsStale) buildRuns();
+        std::set<std::string> result;
+        size_t begin = 0;
+        for (uint32_t end : runEnds) {
+            const std::string& first = students[runRows[begin]].m_group;
+            bool distinct = false;
+            for (size_t i = begin + 1; i < end && !distinct; i++) {
+                distinct = students[runRows[i]].m_group != first;
+            }
+            if (distinct) {
+                for (size_t i = begin; i < end; i++) {
+                    result.insert(students[runRows[i]].m_group);
+                }
+            }
+            begin = end;
+        }
+        return result;
+    }
+};
+
+// Variant 3: Map-based (BST approach)
+class MapDB : public PostingIndexDB<std::map<std::string, std::vector<size_t>>> {
+protected:
+    size_t namesMemoryUsage() const override {
+        // 32 is BSD overhead
+        return PostingIndexDB::namesMemoryUsage() + nameIndex.size() * 32;
+    }
+
+public:
+    explicit MapDB(DatabaseOptions options = {}) : PostingIndexDB(options) {}
 };
 
 #endif
@@ -0,0 +1,104 @@
+#ifndef DUPLICATE_GROUP_TRACKER_H
+#define DUPLICATE_GROUP_TRACKER_H
+
+#include <string>
+#include <unordered_map>
+#include <map>
+#include <set>
+
+// Keeps the answer of findGroupsWithDuplicateNameSurname up to date while
+// students are added or change group, so a query costs O(result size).
+//
+// For every name|surname key we store how many students of each group carry it.
+// A key with more than one distinct group "retains" all of its groups in
+// duplicateGroups, which is a refcount of how many such keys mention the group.
+class DuplicateGroupTracker {
+private:
+    std::unordered_map<std::string, std::unordered_map<std::string, size_t>> keyGroups;
+    std::map<std::string, size_t> duplicateGroups;
+
+    void retain(const std::string& group) {
+        duplicateGroups[group]++;
+    }
+
+    void release(const std::string& group) {
+        auto it = duplicateGroups.find(group);
+        if (--it->second == 0) {
+            duplicateGroups.erase(it);
+        }
+    }
+
+public:
+    void clear() {
+        keyGroups.clear();
+        duplicateGroups.clear();
+    }
+
+    void add(const std::string& key, const std::string& group) {
+        auto& counts = keyGroups[key];
+        if (counts[group]++ > 0) return;
+
+        // Group is new for this key
+        if (counts.size() == 2) {
+            // Key just became a duplicate - all its groups count now
+            for (const auto& [g, c] : counts) {
+                retain(g);
+            }
+        } else if (counts.size() > 2) {
+            retain(group);
+        }
+    }
+
+    void remove(const std::string& key, const std::string& group) {
+        auto keyIt = keyGroups.find(key);
+        if (keyIt == keyGroups.end()) return;
+        auto& counts = keyIt->second;
+        auto it = counts.find(group);
+        if (it == counts.end() || --it->second > 0) return;
+
+        // Last student of this group with this key is gone
+        if (counts.size() == 2) {
+            // Key stops being a duplicate - drop both groups
+            for (const auto& [g, c] : counts) {
+                release(g);
+            }
+        } else if (counts.size() > 2) {
+            release(group);
+        }
+        counts.erase(it);
+        if (counts.empty()) {
+            keyGroups.erase(keyIt);
+        }
+    }
+
+    void move(const std::string& key, const std::string& oldGroup, const std::string& newGroup) {
+        if (oldGroup == newGroup) return;
+        add(key, newGroup);
+        remove(key, oldGroup);
+    }
+
+    std::set<std::string> groups() const {
+        std::set<std::string> result;
+        for (const auto& [group, refs] : duplicateGroups) {
+            result.insert(result.end(), group);
+        }
+        return result;
+    }
+
+    size_t getMemoryUsage() const {
+        size_t size = 0;
+        for (const auto& [k, counts] : keyGroups) {
+            size += k.capacity() + sizeof(size_t);
+            for (const auto& [g, c] : counts) {
+                size += g.capacity() + sizeof(size_t);
+            }
+        }
+        for (const auto& [g, c] : duplicateGroups) {
+            // 32 is BSD overhead
+            size += g.capacity() + sizeof(size_t) + 32;
+        }
+        return size;
+    }
+};
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef DURABLE_DB_H
+#define DURABLE_DB_H
+
+#include "Database.h"
+#include "ChangeLog.h"
+
+// Makes the group changes of any variant survive a restart.
+//
+// Every load (CSV or snapshot) loads the wrapped database, replays the
+// change log on top of it and reopens the log for appending. From then on
+// each updateGroupByEmail that finds its email is appended to the log and
+// made durable as the CommitPolicy says. A crash loses at most the records
+// of the last uncommitted batch or interval.
+//
+// checkpoint() writes a snapshot that already holds the logged changes and
+// empties the log, so the next start loads that snapshot instead of the
+// CSV. Replaying a change twice sets the same group again, so a crash
+// between the two steps is harmless.
+//
+// Only group changes are logged, so upsertStudents and removeByEmail are
+// not passed through: ingest into the wrapped database, then checkpoint.
+//
+// Not thread-safe by itself: wrap it in SharedLockDB to share it, so the
+// log order matches the order the updates were applied in.
+class DurableDB : public IDatabase {
+private:
+    IDatabase& db;
+    std::string logFilename;
+    CommitPolicy policy;
+    ChangeLog log;
+    size_t replayed = 0;
+
+    bool replayLog() {
+        size_t validBytes = 0;
+        replayed = ChangeLog::replay(logFilename, [&](const std::string& email, const std::string& group) {
+            db.updateGroupByEmail(email, group);
+        }, &validBytes);
+        return log.open(logFilename, policy, validBytes);
+    }
+
+public:
+    DurableDB(IDatabase& db, const std::string& logFilename, CommitPolicy policy = {})
+        : db(db), logFilename(logFilename), policy(policy) {}
+
+    void loadFromFile(const std::string& filename) override {
+        log.close();
+        db.loadFromFile(filename);
+        replayLog();
+    }
+
+    void loadFromFileParallel(const std::string& filename, size_t threads) override {
+        log.close();
+        db.loadFromFileParallel(filename, threads);
+        replayLog();
+    }
+
+    bool saveSnapshot(const std::string& filename) const override {
+        return db.saveSnapshot(filename);
+    }
+
+    bool loadSnapshot(const std::string& filename) override {
+        log.close();
+        if (!db.loadSnapshot(filename)) return false;
+        return replayLog();
+    }
+
+    RowSpan findRowsByNameSurname(const std::string& name, const std::string& surname,
+                                  std::vector<size_t>& scratch) const override {
+        return db.findRowsByNameSurname(name, surname, scratch);
+    }
+
+    std::set<std::string> findGroupsWithDuplicateNameSurname() override {
+        return db.findGroupsWithDuplicateNameSurname();
+    }
+
+    bool updateGroupByEmail(const std::string& email, const std::string& newGroup) override {
+        if (!db.updateGroupByEmail(email, newGroup)) return false;
+        if (log.isOpen()) log.append(email, newGroup);
+        return true;
+    }
+
+    void findRowsByNameSurnameBatch(const std::vector<NameQuery>& queries,
+                                    std::vector<RowSpan>& results, std::vector<size_t>& scratch) const override {
+        db.findRowsByNameSurnameBatch(queries, results, scratch);
+    }
+
+    size_t rowCount() const override {
+        return db.rowCount();
+    }
+
+    StudentView getRow(size_t row) const override {
+        return db.getRow(row);
+    }
+
+    bool isRemoved(size_t row) const override {
+        return db.isRemoved(row);
+    }
+
+    size_t getMemoryUsage() const override {
+        return db.getMemoryUsage();
+    }
+
+    const BloomFilter* getNameFilter() const override {
+        return db.getNameFilter();
+    }
+
+    // Makes every change so far durable, whatever the policy; false on I/O errors
+    bool commit() {
+        return log.commit();
+    }
+
+    // Saves a snapshot of the current data to `filename` and empties the log;
+    // false (log left as is) if the snapshot cannot be written
+    bool checkpoint(const std::string& filename) {
+        if (!commit() || !db.saveSnapshot(filename)) return false;
+        log.close();
+        return log.open(logFilename, policy, 0);
+    }
+
+    // False when the log could not be opened: updates then only change memory
+    bool isDurable() const {
+        return log.isOpen();
+    }
+
+    // Changes replayed by the last load
+    size_t replayedCount() const {
+        return replayed;
+    }
+
+    // Changes logged and fsyncs made since the last load
+    size_t loggedCount() {
+        return log.recordCount();
+    }
+
+    size_t syncCount() {
+        return log.syncCount();
+    }
+};
+
+#endif
@@ -0,0 +1,299 @@
+#ifndef EXTERNAL_SORTER_H
+#define EXTERNAL_SORTER_H
+
+#include "Sorter.h"
+#include "CsvReader.h"
+#include "CsvWriter.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+// Sorts a CSV roster by (surname, name) without holding it in memory.
+//
+// Rows are parsed into runs of at most about `memoryBudget` bytes (rows,
+// their strings and the radix sort's buffers), each run is radix sorted and
+// spilled to a binary run file, and the runs are merged into the output CSV
+// with a loser tree. When there are more runs than the budget can buffer at
+// once, groups of runs are first merged into longer runs.
+//
+// Runs are consecutive slices of the input and ties go to the earlier run,
+// so the output is byte-identical to Sorter::radixSort + saveToCSV on the
+// whole file. Run files are written next to the output and removed after.
+class ExternalSorter {
+private:
+    // Smallest read buffer given to one run while merging
+    static constexpr size_t MIN_RUN_BUFFER = 64 * 1024;
+    // Past this, a bigger read buffer no longer saves anything
+    static constexpr size_t MAX_RUN_BUFFER = 1024 * 1024;
+    // Per row: the row in the run and in radixSort's output vector, plus its
+    // key bytes, key offset and two 24-byte radix entries
+    static constexpr size_t ROW_OVERHEAD = 2 * sizeof(Student) + sizeof(size_t) + 2 * 24;
+
+    size_t memoryBudget;
+    size_t threads;
+    size_t runs = 0;
+    size_t mergePasses = 0;
+
+    // Run file record: three uint32 lengths, then surname, name and the CSV line
+    class RunWriter {
+    private:
+        std::ofstream file;
+        std::string buffer;
+        size_t bufferSize;
+
+    public:
+        RunWriter(const std::string& filename, size_t bufferSize)
+            : file(filename, std::ios::binary | std::ios::trunc), bufferSize(bufferSize) {
+            buffer.reserve(bufferSize);
+        }
+
+        // Formats the CSV line in place and fills in its length afterwards
+        void addStudent(const Student& s) {
+            StudentView view(s);
+            uint32_t lengths[3] = {static_cast<uint32_t>(s.m_surname.size()), static_cast<uint32_t>(s.m_name.size()), 0};
+            size_t start = buffer.size();
+            buffer.resize(start + sizeof(lengths) + lengths[0] + lengths[1] + view.csvSizeBound());
+            char* out = buffer.data() + start + sizeof(lengths);
+            std::memcpy(out, s.m_surname.data(), lengths[0]);
+            std::memcpy(out + lengths[0], s.m_name.data(), lengths[1]);
+            char* line = out + lengths[0] + lengths[1];
+            char* end = view.formatCSV(line);
+            lengths[2] = static_cast<uint32_t>(end - line);
+            std::memcpy(buffer.data() + start, lengths, sizeof(lengths));
+            buffer.resize(end - buffer.data());
+            if (buffer.size() >= bufferSize) flush();
+        }
+
+        void add(std::string_view surname, std::string_view name, std::string_view line) {
+            uint32_t lengths[3] = {static_cast<uint32_t>(surname.size()), static_cast<uint32_t>(name.size()),
+                                   static_cast<uint32_t>(line.size())};
+            buffer.append(reinterpret_cast<const char*>(lengths), sizeof(lengths));
+            buffer += surname;
+            buffer += name;
+            buffer += line;
+            if (buffer.size() >= bufferSize) flush();
+        }
+
+        void flush() {
+            file.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+
+        bool close() {
+            flush();
+            file.close();
+            return !file.fail();
+        }
+    };
+
+    // Streams the records of one run file; the views of the current record
+    // stay valid until the next call to next()
+    class RunReader {
+    private:
+        std::ifstream file;
+        std::vector<char> buffer;
+        size_t pos = 0;
+        size_t end = 0;
+        bool done = false;
+
+        // Makes `bytes` unread bytes available at pos
+        bool fill(size_t bytes) {
+            if (end - pos >= bytes) return true;
+            std::memmove(buffer.data(), buffer.data() + pos, end - pos);
+            end -= pos;
+            pos = 0;
+            if (buffer.size() < bytes) buffer.resize(bytes);
+            file.read(buffer.data() + end, buffer.size() - end);
+            end += file.gcount();
+            return end >= bytes;
+        }
+
+    public:
+        std::string_view surname;
+        std::string_view name;
+        std::string_view line;
+
+        RunReader(const std::string& filename, size_t bufferSize)
+            : file(filename, std::ios::binary), buffer(bufferSize) {
+            next();
+        }
+
+        bool exhausted() const { return done; }
+
+        void next() {
+            uint32_t lengths[3];
+            if (!fill(sizeof(lengths))) {
+                done = true;
+                return;
+            }
+            std::memcpy(lengths, buffer.data() + pos, sizeof(lengths));
+            size_t size = sizeof(lengths) + size_t(lengths[0]) + lengths[1] + lengths[2];
+            if (!fill(size)) {
+                done = true;
+                return;
+            }
+            const char* record = buffer.data() + pos + sizeof(lengths);
+            surname = std::string_view(record, lengths[0]);
+            name = std::string_view(record + lengths[0], lengths[1]);
+            line = std::string_view(record + lengths[0] + lengths[1], lengths[2]);
+            pos += size;
+        }
+    };
+
+    static std::string runFileName(const std::string& output, size_t index) {
+        return output + ".run" + std::to_string(index);
+    }
+
+    // Heap bytes of a string that does not fit the small string buffer
+    static size_t heapBytes(const std::string& s) {
+        return s.capacity() > 15 ? s.capacity() + 1 : 0;
+    }
+
+    static size_t rowBytes(const Student& s) {
+        return ROW_OVERHEAD + heapBytes(s.m_name) + heapBytes(s.m_surname) + heapBytes(s.m_email) +
+               heapBytes(s.m_group) + heapBytes(s.m_phone_number) + s.m_surname.size() + s.m_name.size() + 1;
+    }
+
+    // Largest number of runs one merge can read at MIN_RUN_BUFFER each
+    size_t maxFanIn() const {
+        return std::max<size_t>(2, memoryBudget / MIN_RUN_BUFFER);
+    }
+
+    bool spillRun(std::vector<Student>& students, const std::string& filename) {
+        Sorter::radixSort(students, threads);
+        RunWriter writer(filename, MIN_RUN_BUFFER);
+        for (const auto& s : students) {
+            writer.addStudent(s);
+        }
+        students.clear();
+        return writer.close();
+    }
+
+    // Merges the run files in order, calling emit(reader) for every record.
+    // The loser tree keeps the losing run of each match in its inner nodes,
+    // so replacing the winner replays only the log2(k) matches on its path.
+    template <typename Emit>
+    void mergeRuns(const std::vector<std::string>& files, Emit emit) const {
+        const size_t k = files.size();
+        size_t bufferSize = std::clamp(memoryBudget / (k + 1), MIN_RUN_BUFFER, MAX_RUN_BUFFER);
+        std::vector<RunReader> readers;
+        readers.reserve(k);
+        for (const auto& file : files) {
+            readers.emplace_back(file, bufferSize);
+        }
+
+        // Run a beats run b: it has a smaller key, or an equal key and an earlier run
+        auto beats = [&](size_t a, size_t b) {
+            if (readers[a].exhausted()) return false;
+            if (readers[b].exhausted()) return true;
+            int cmp = readers[a].surname.compare(readers[b].surname);
+            if (cmp == 0) cmp = readers[a].name.compare(readers[b].name);
+            return cmp != 0 ? cmp < 0 : a < b;
+        };
+
+        // tree[0] is the overall winner, tree[1..k) the loser of each inner node;
+        // leaf i sits at position k + i
+        std::vector<size_t> tree(k);
+        std::vector<size_t> winners(2 * k);
+        for (size_t i = 0; i < k; i++) {
+            winners[k + i] = i;
+        }
+        for (size_t node = k - 1; node >= 1; node--) {
+            size_t a = winners[2 * node], b = winners[2 * node + 1];
+            bool aWins = beats(a, b);
+            winners[node] = aWins ? a : b;
+            tree[node] = aWins ? b : a;
+        }
+        tree[0] = winners[1];
+
+        for (;;) {
+            size_t winner = tree[0];
+            if (readers[winner].exhausted()) break;
+            emit(readers[winner]);
+            readers[winner].next();
+            for (size_t node = (winner + k) / 2; node >= 1; node /= 2) {
+                if (beats(tree[node], winner)) std::swap(tree[node], winner);
+            }
+            tree[0] = winner;
+        }
+    }
+
+public:
+    explicit ExternalSorter(size_t memoryBudget, size_t threads = 1)
+        : memoryBudget(memoryBudget), threads(threads) {}
+
+    // Sorts the rows of `input` into the CSV file `output`; false on I/O failure
+    bool sort(const std::string& input, const std::string& output) {
+        runs = 0;
+        mergePasses = 0;
+
+        // The input is mapped, not read: its pages are file backed and
+        // dropped by the kernel as needed, so they do not count against the budget
+        std::vector<std::string> files;
+        bool ok = true;
+        {
+            CsvReader reader(input);
+            std::vector<Student> students;
+            size_t used = 0;
+            reader.forEachStudent([&](Student&& s) {
+                used += rowBytes(s);
+                students.push_back(std::move(s));
+                if (used >= memoryBudget) {
+                    files.push_back(runFileName(output, files.size()));
+                    ok &= spillRun(students, files.back());
+                    used = 0;
+                }
+            });
+            if (!students.empty() || files.empty()) {
+                files.push_back(runFileName(output, files.size()));
+                ok &= spillRun(students, files.back());
+            }
+        }
+        runs = files.size();
+
+        // Merge consecutive groups until one pass can take every run; keeping
+        // groups consecutive keeps the earlier-run-wins tie rule valid
+        size_t nextFile = files.size();
+        while (ok && files.size() > maxFanIn()) {
+            std::vector<std::string> merged;
+            for (size_t first = 0; first < files.size(); first += maxFanIn()) {
+                std::vector<std::string> group(files.begin() + first,
+                                               files.begin() + std::min(files.size(), first + maxFanIn()));
+                merged.push_back(runFileName(output, nextFile++));
+                RunWriter writer(merged.back(), MIN_RUN_BUFFER);
+                mergeRuns(group, [&](const RunReader& r) { writer.add(r.surname, r.name, r.line); });
+                ok &= writer.close();
+                for (const auto& file : group) {
+                    std::remove(file.c_str());
+                }
+            }
+            files.swap(merged);
+            mergePasses++;
+        }
+
+        if (ok) {
+            CsvWriter out(output);
+            mergeRuns(files, [&](const RunReader& r) { out.writeLine(r.line); });
+            ok = out.close();
+            mergePasses++;
+        }
+
+        for (const auto& file : files) {
+            std::remove(file.c_str());
+        }
+        return ok;
+    }
+
+    // Sorted runs spilled by the last sort()
+    size_t runCount() const { return runs; }
+
+    // Merge passes of the last sort(), the final merge included
+    size_t mergePassCount() const { return mergePasses; }
+};
+
+#endif
@@ -0,0 +1,381 @@
+#ifndef FLAT_HASH_DB_H
+#define FLAT_HASH_DB_H
+
+#include "Database.h"
+#include "FlatHashIndex.h"
+#include "PerfectHashIndex.h"
+#include <vector>
+#include <cstdint>
+
+// Variant 6: Flat (SwissTable style) hash indexes
+// Same row storage as HashMapDB, but both indexes are FlatHashIndex tables of
+// 32-bit ids probed with SIMD fingerprint matching. Lookups hash (name,
+// surname) as two string_views and compare against the stored rows, so no
+// key string is ever built. Rows of each name key are kept contiguous in one
+// postings array (offsets per key), so a query returns a span into it.
+class FlatHashDB : public IDatabase {
+private:
+    std::vector<Student> students;
+    FlatHashIndex nameIndex;              // -> key id
+    FlatHashIndex emailIndex;             // -> row
+    PerfectHashIndex perfectEmails;       // -> row, replaces emailIndex when the option is set
+    std::vector<uint32_t> keyRows;        // key id -> first row with that key
+    std::vector<size_t> postingOffsets;   // key id -> start in postings
+    std::vector<size_t> postings;         // rows grouped by key, ascending
+    DatabaseOptions options;
+    DuplicateGroupTracker duplicates;
+    BloomFilter nameFilter;
+    // Streaming load only, freed by endLoad: hashes for table growth, key id per row
+    std::vector<uint64_t> loadKeyHashes;    // key id -> name hash
+    std::vector<uint64_t> loadEmailHashes;  // row -> email hash
+    std::vector<uint32_t> loadRowKeys;      // row -> key id
+
+    static uint64_t nameHash(const Student& s) {
+        return hashKeyParts(s.m_name, s.m_surname);
+    }
+
+    static uint64_t emailHash(const Student& s) {
+        return hashKeyParts(s.m_email);
+    }
+
+    auto nameKeyEquals(std::string_view name, std::string_view surname) const {
+        return [this, name, surname](uint32_t key) {
+            const Student& s = students[keyRows[key]];
+            return s.m_name == name && s.m_surname == surname;
+        };
+    }
+
+    auto emailEquals(std::string_view email) const {
+        return [this, email](uint32_t row) {
+            return students[row].m_email == email;
+        };
+    }
+
+    const uint32_t* findEmail(uint64_t hash, std::string_view email) const {
+        if (options.perfectEmailIndex) return perfectEmails.find(hash, emailEquals(email));
+        return emailIndex.find(hash, emailEquals(email));
+    }
+
+    void prefetchEmail(uint64_t hash) const {
+        if (options.perfectEmailIndex) {
+            perfectEmails.prefetch(hash);
+        } else {
+            emailIndex.prefetch(hash);
+        }
+    }
+
+    void clearIndexes() {
+        nameIndex.clear();
+        emailIndex.clear();
+        perfectEmails.clear();
+        keyRows.clear();
+        duplicates.clear();
+    }
+
+    // Adds row i to the name table, and to the email table unless the perfect
+    // index replaces it; returns the row's key id. keyHashOf / rowHashOf give
+    // the hashes of stored ids when a table grows.
+    template <typename KeyHashOf, typename RowHashOf>
+    uint32_t indexRow(size_t i, uint64_t nameHash, uint64_t emailHash, KeyHashOf keyHashOf, RowHashOf rowHashOf) {
+        const Student& s = students[i];
+        uint32_t newKey = static_cast<uint32_t>(keyRows.size());
+        auto [key, inserted] = nameIndex.insert(nameHash, newKey, nameKeyEquals(s.m_name, s.m_surname), keyHashOf);
+        if (inserted) keyRows.push_back(static_cast<uint32_t>(i));
+
+        // Later rows with the same email win, as in the other variants
+        if (!options.perfectEmailIndex) {
+            AllocationScope email(AllocationTag::EmailIndex);
+            auto [row, added] = emailIndex.insert(emailHash, static_cast<uint32_t>(i), emailEquals(s.m_email), rowHashOf);
+            *row = static_cast<uint32_t>(i);
+        }
+
+        if (options.incrementalDuplicates) {
+            AllocationScope other(AllocationTag::Other);
+            duplicates.add(s.m_name + "|" + s.m_surname, s.m_group);
+        }
+        return *key;
+    }
+
+    template <typename RowHashOf>
+    void buildPerfectEmails(RowHashOf rowHashOf) {
+        AllocationScope email(AllocationTag::EmailIndex);
+        perfectEmails.build(students.size(), rowHashOf, [&](uint32_t a, uint32_t b) {
+            return students[a].m_email == students[b].m_email;
+        });
+    }
+
+    // Counting sort of rows by key id keeps each key's rows ascending
+    void buildPostings(const std::vector<uint32_t>& rowKeys) {
+        size_t rows = rowKeys.size();
+        postingOffsets.assign(keyRows.size() + 1, 0);
+        for (uint32_t key : rowKeys) postingOffsets[key + 1]++;
+        for (size_t k = 0; k < keyRows.size(); k++) postingOffsets[k + 1] += postingOffsets[k];
+        postings.resize(rows);
+        std::vector<size_t> cursor(postingOffsets.begin(), postingOffsets.end() - 1);
+        for (size_t i = 0; i < rows; i++) {
+            postings[cursor[rowKeys[i]]++] = i;
+        }
+    }
+
+    // Builds both indexes over the loaded rows; hashes are computed on `threads` cores.
+    // The name table, key rows and postings are charged to NameIndex.
+    void buildIndexes(size_t threads) {
+        AllocationScope scope(AllocationTag::NameIndex);
+        clearIndexes();
+
+        size_t rows = students.size();
+        std::vector<uint64_t> nameHashes(rows), emailHashes(rows);
+        parallelFor(threads, [&](size_t t) {
+            for (size_t i = rows * t / threads; i < rows * (t + 1) / threads; i++) {
+                nameHashes[i] = nameHash(students[i]);
+                emailHashes[i] = emailHash(students[i]);
+            }
+        });
+
+        auto keyHashOf = [&](uint32_t key) { return nameHashes[keyRows[key]]; };
+        auto rowHashOf = [&](uint32_t row) { return emailHashes[row]; };
+        if (options.perfectEmailIndex) {
+            buildPerfectEmails(rowHashOf);
+        } else {
+            AllocationScope email(AllocationTag::EmailIndex);
+            emailIndex.reserve(rows, rowHashOf);
+        }
+
+        std::vector<uint32_t> rowKeys(rows);
+        for (size_t i = 0; i < rows; i++) {
+            rowKeys[i] = indexRow(i, nameHashes[i], emailHashes[i], keyHashOf, rowHashOf);
+        }
+        buildPostings(rowKeys);
+    }
+
+    // Streaming load: the tables take every row as it arrives, growing as
+    // they go. Only what needs all rows waits for endLoad: the contiguous
+    // postings, the perfect email index and the name filter.
+    void appendLoadedRow(Student&& s) {
+        {
+            AllocationScope rows(AllocationTag::Students);
+            students.push_back(std::move(s));
+        }
+        AllocationScope scope(AllocationTag::NameIndex);
+        size_t i = students.size() - 1;
+        uint64_t hash = nameHash(students[i]);
+        loadEmailHashes.push_back(emailHash(students[i]));
+        uint32_t key = indexRow(i, hash, loadEmailHashes[i],
+                                [&](uint32_t key) { return loadKeyHashes[key]; },
+                                [&](uint32_t row) { return loadEmailHashes[row]; });
+        if (key == loadKeyHashes.size()) loadKeyHashes.push_back(hash);
+        loadRowKeys.push_back(key);
+    }
+
+    RowSpan keyPostings(uint32_t key) const {
+        return RowSpan(postings.data() + postingOffsets[key], postingOffsets[key + 1] - postingOffsets[key]);
+    }
+
+public:
+    explicit FlatHashDB(DatabaseOptions options = {}) : options(options) {}
+
+    void loadFromFile(const std::string& filename) override {
+        CsvReader reader(filename);
+
+        beginLoad();
+        // Rows are parsed under Students, each insert is charged to its own structure
+        {
+            AllocationScope rows(AllocationTag::Students);
+            reader.forEachStudent([&](Student&& s) {
+                appendLoadedRow(std::move(s));
+            });
+        }
+        endLoad();
+    }
+
+    bool beginLoad() override {
+        students.clear();
+        clearIndexes();
+        loadKeyHashes.clear();
+        loadEmailHashes.clear();
+        loadRowKeys.clear();
+        return true;
+    }
+
+    void appendLoadedRows(std::vector<Student>& rows) override {
+        for (Student& s : rows) {
+            appendLoadedRow(std::move(s));
+        }
+        rows.clear();
+    }
+
+    void endLoad() override {
+        {
+            AllocationScope scope(AllocationTag::NameIndex);
+            buildPostings(loadRowKeys);
+            if (options.perfectEmailIndex) buildPerfectEmails([&](uint32_t row) { return loadEmailHashes[row]; });
+        }
+        std::vector<uint64_t>().swap(loadKeyHashes);
+        std::vector<uint64_t>().swap(loadEmailHashes);
+        std::vector<uint32_t>().swap(loadRowKeys);
+        if (options.nameFilter) buildNameFilter(nameFilter);
+    }
+
+    void loadFromFileParallel(const std::string& filename, size_t threads) override {
+        CsvReader reader(filename);
+
+        {
+            AllocationScope scope(AllocationTag::Students);
+            students = reader.parseParallel(threads);
+        }
+        buildIndexes(std::max<size_t>(1, threads));
+        if (options.nameFilter) buildNameFilter(nameFilter);
+    }
+
+    bool saveSnapshot(const std::string& filename) const override {
+        SnapshotWriter writer;
+        for (const auto& s : students) {
+            writer.addStudent(s);
+        }
+        for (uint32_t key = 0; key < keyRows.size(); key++) {
+            writer.addNameEntry(keyPostings(key));
+        }
+        for (size_t row = 0; row < students.size(); row++) {
+            const uint32_t* owner = findEmail(emailHash(students[row]), students[row].m_email);
+            if (*owner == row) writer.addEmailRow(row);
+        }
+        return writer.write(filename);
+    }
+
+    bool loadSnapshot(const std::string& filename) override {
+        SnapshotReader reader(filename);
+        if (!reader.isValid()) return false;
+
+        // Flat tables rebuild from the rows in one pass
+        {
+            AllocationScope scope(AllocationTag::Students);
+            students = reader.students();
+        }
+        buildIndexes(1);
+        if (options.nameFilter) buildNameFilter(nameFilter);
+        return true;
+    }
+
+    RowSpan findRowsByNameSurname(const std::string& name, const std::string& surname,
+                                  std::vector<size_t>& scratch) const override {
+        uint64_t hash = hashKeyParts(name, surname);
+        if (options.nameFilter && !nameFilter.mayContain(hash)) return RowSpan();
+        const uint32_t* key = nameIndex.find(hash, nameKeyEquals(name, surname));
+        if (!key) return RowSpan();
+        return keyPostings(*key);
+    }
+
+    std::set<std::string> findGroupsWithDuplicateNameSurname() override {
+        if (options.incrementalDuplicates) {
+            return duplicates.groups();
+        }
+        std::set<std::string> result;
+        for (uint32_t key = 0; key < keyRows.size(); key++) {
+            RowSpan rows = keyPostings(key);
+            if (rows.size() > 1) {
+                std::set<std::string> groups;
+                for (size_t idx : rows) {
+                    groups.insert(students[idx].m_group);
+                }
+                if (groups.size() > 1) {
+                    result.insert(groups.begin(), groups.end());
+                }
+            }
+        }
+        return result;
+    }
+
+    bool updateGroupByEmail(const std::string& email, const std::string& newGroup) override {
+        const uint32_t* row = findEmail(hashKeyParts(email), email);
+        if (!row) return false;
+
+        Student& s = students[*row];
+        if (options.incrementalDuplicates) {
+            duplicates.move(s.m_name + "|" + s.m_surname, s.m_group, newGroup);
+        }
+        s.m_group = newGroup;
+        return true;
+    }
+
+    // Batched requests run in passes over each window: hash every key and
+    // prefetch its probe group, then probe (and prefetch rows to update)
+    void findRowsByNameSurnameBatch(const std::vector<NameQuery>& queries,
+                                    std::vector<RowSpan>& results, std::vector<size_t>& scratch) const override {
+        results.resize(queries.size());
+        uint64_t hashes[BATCH_WINDOW];
+        for (size_t begin = 0; begin < queries.size(); begin += BATCH_WINDOW) {
+            size_t end = std::min(queries.size(), begin + BATCH_WINDOW);
+            for (size_t i = begin; i < end; i++) {
+                hashes[i - begin] = hashKeyParts(queries[i].name, queries[i].surname);
+                nameIndex.prefetch(hashes[i - begin]);
+            }
+            for (size_t i = begin; i < end; i++) {
+                const NameQuery& q = queries[i];
+                uint64_t hash = hashes[i - begin];
+                results[i] = RowSpan();
+                if (options.nameFilter && !nameFilter.mayContain(hash)) continue;
+                if (const uint32_t* key = nameIndex.find(hash, nameKeyEquals(q.name, q.surname))) {
+                    results[i] = keyPostings(*key);
+                }
+            }
+        }
+    }
+
+    size_t updateGroupByEmailBatch(const std::vector<GroupUpdate>& updates) override {
+        size_t updated = 0;
+        uint64_t hashes[BATCH_WINDOW];
+        size_t targets[BATCH_WINDOW];
+        for (size_t begin = 0; begin < updates.size(); begin += BATCH_WINDOW) {
+            size_t end = std::min(updates.size(), begin + BATCH_WINDOW);
+            for (size_t i = begin; i < end; i++) {
+                hashes[i - begin] = hashKeyParts(updates[i].email);
+                prefetchEmail(hashes[i - begin]);
+            }
+            for (size_t i = begin; i < end; i++) {
+                const uint32_t* row = findEmail(hashes[i - begin], updates[i].email);
+                targets[i - begin] = row ? *row : NOT_FOUND;
+                if (row) {
+                    __builtin_prefetch(&students[*row].m_group, 1);
+                }
+            }
+            for (size_t i = begin; i < end; i++) {
+                if (targets[i - begin] == NOT_FOUND) continue;
+                Student& s = students[targets[i - begin]];
+                if (options.incrementalDuplicates) {
+                    duplicates.move(s.m_name + "|" + s.m_surname, s.m_group, updates[i].newGroup);
+                }
+                s.m_group = updates[i].newGroup;
+                updated++;
+            }
+        }
+        return updated;
+    }
+
+    size_t rowCount() const override {
+        return students.size();
+    }
+
+    StudentView getRow(size_t row) const override {
+        return students[row];
+    }
+
+    size_t getMemoryUsage() const override {
+        size_t size = students.capacity() * sizeof(Student);
+        size += nameIndex.getMemoryUsage() + emailIndex.getMemoryUsage() + perfectEmails.getMemoryUsage();
+        size += keyRows.capacity() * sizeof(uint32_t);
+        size += postingOffsets.capacity() * sizeof(size_t) + postings.capacity() * sizeof(size_t);
+        if (options.incrementalDuplicates) {
+            size += duplicates.getMemoryUsage();
+        }
+        if (options.nameFilter) {
+            size += nameFilter.getMemoryUsage();
+        }
+        return size;
+    }
+
+    const BloomFilter* getNameFilter() const override {
+        return options.nameFilter ? &nameFilter : nullptr;
+    }
+};
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef FLAT_HASH_INDEX_H
+#define FLAT_HASH_INDEX_H
+
+#include "KeyHash.h"
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Open addressing index in the style of SwissTable.
+//
+// Slots hold 32-bit values (row ids, entry ids); keys are not stored. Callers
+// pass the key hash plus an equality test that checks a candidate value
+// against the key, so compound keys never need to be materialized.
+// Each slot has a control byte: EMPTY or the top 7 bits of the hash. Probing
+// compares 16 control bytes at once (SSE2, scalar fallback) and only calls
+// the equality test on fingerprint matches.
+class FlatHashIndex {
+private:
+    static constexpr size_t GROUP_WIDTH = 16;
+    static constexpr int8_t EMPTY = -128;
+
+    // capacity + GROUP_WIDTH bytes; the tail mirrors the first bytes so a
+    // group can be loaded at any position without wrapping
+    std::vector<int8_t> ctrl;
+    std::vector<uint32_t> slots;
+    size_t mask = 0;
+    size_t count = 0;
+
+    // The probe start comes from the low bits, the fingerprint from the top
+    // 7, so slots that share a group rarely share a fingerprint too
+    static size_t slotHash(uint64_t hash) { return static_cast<size_t>(hash); }
+    static int8_t fingerprint(uint64_t hash) { return static_cast<int8_t>(hash >> 57); }
+
+    // Bit i set when control byte pos + i equals value
+    uint32_t matchGroup(size_t pos, int8_t value) const {
+#ifdef __SSE2__
+        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl.data() + pos));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(value))));
+#else
+        uint32_t bits = 0;
+        for (size_t i = 0; i < GROUP_WIDTH; i++) {
+            if (ctrl[pos + i] == value) bits |= 1u << i;
+        }
+        return bits;
+#endif
+    }
+
+    void setCtrl(size_t i, int8_t value) {
+        ctrl[i] = value;
+        if (i < GROUP_WIDTH) ctrl[mask + 1 + i] = value;
+    }
+
+    // Slot holding a value equal to the key, or the first empty slot of its probe sequence
+    template <typename Eq>
+    std::pair<size_t, bool> probe(uint64_t hash, Eq eq) const {
+        int8_t fp = fingerprint(hash);
+        size_t pos = slotHash(hash) & mask;
+        for (size_t step = GROUP_WIDTH;; step += GROUP_WIDTH) {
+            for (uint32_t bits = matchGroup(pos, fp); bits != 0; bits &= bits - 1) {
+                size_t i = (pos + __builtin_ctz(bits)) & mask;
+                if (eq(slots[i])) return {i, true};
+            }
+            uint32_t empty = matchGroup(pos, EMPTY);
+            if (empty != 0) return {(pos + __builtin_ctz(empty)) & mask, false};
+            pos = (pos + step) & mask;
+        }
+    }
+
+    template <typename HashOf>
+    void rehash(size_t capacity, HashOf hashOf) {
+        std::vector<int8_t> oldCtrl(capacity + GROUP_WIDTH, EMPTY);
+        std::vector<uint32_t> oldSlots(capacity);
+        oldCtrl.swap(ctrl);
+        oldSlots.swap(slots);
+        size_t oldCapacity = mask + 1;
+        mask = capacity - 1;
+
+        if (oldSlots.empty()) return;
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (oldCtrl[i] == EMPTY) continue;
+            uint64_t hash = hashOf(oldSlots[i]);
+            auto [slot, found] = probe(hash, [](uint32_t) { return false; });
+            setCtrl(slot, fingerprint(hash));
+            slots[slot] = oldSlots[i];
+        }
+    }
+
+public:
+    size_t size() const { return count; }
+
+    void clear() {
+        ctrl.clear();
+        slots.clear();
+        mask = 0;
+        count = 0;
+    }
+
+    // Makes room for n values at load factor <= 7/8.
+    // hashOf(value) recomputes the hash of an already stored value.
+    template <typename HashOf>
+    void reserve(size_t n, HashOf hashOf) {
+        size_t capacity = GROUP_WIDTH;
+        while (capacity * 7 / 8 < n) capacity *= 2;
+        if (slots.empty() || capacity > mask + 1) rehash(capacity, hashOf);
+    }
+
+    // Hint to pull the start of the probe sequence into cache
+    void prefetch(uint64_t hash) const {
+        if (slots.empty()) return;
+        size_t pos = slotHash(hash) & mask;
+        __builtin_prefetch(ctrl.data() + pos);
+        __builtin_prefetch(slots.data() + pos);
+    }
+
+    template <typename Eq>
+    const uint32_t* find(uint64_t hash, Eq eq) const {
+        if (slots.empty()) return nullptr;
+        auto [slot, found] = probe(hash, eq);
+        return found ? &slots[slot] : nullptr;
+    }
+
+    template <typename Eq>
+    uint32_t* find(uint64_t hash, Eq eq) {
+        return const_cast<uint32_t*>(static_cast<const FlatHashIndex&>(*this).find(hash, eq));
+    }
+
+    // Inserts value unless an equal key exists; returns the slot and whether it was inserted
+    template <typename Eq, typename HashOf>
+    std::pair<uint32_t*, bool> insert(uint64_t hash, uint32_t value, Eq eq, HashOf hashOf) {
+        reserve(count + 1, hashOf);
+        auto [slot, found] = probe(hash, eq);
+        if (!found) {
+            setCtrl(slot, fingerprint(hash));
+            slots[slot] = value;
+            count++;
+        }
+        return {&slots[slot], !found};
+    }
+
+    size_t getMemoryUsage() const {
+        return ctrl.capacity() * sizeof(int8_t) + slots.capacity() * sizeof(uint32_t);
+    }
+};
+
+#endif
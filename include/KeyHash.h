@@ -0,0 +1,25 @@
+#ifndef KEY_HASH_H
+#define KEY_HASH_H
+
+#include <cstdint>
+#include <string_view>
+#include <functional>
+
+// Hash of a key given as several string parts, without concatenating them
+inline uint64_t hashKeyParts(std::string_view first, std::string_view second) {
+    std::hash<std::string_view> hash;
+    uint64_t h = hash(first);
+    h ^= hash(second) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    // Final avalanche: FlatHashIndex probes from the low bits and takes its
+    // fingerprint from the top 7, so both ends have to be well mixed
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+inline uint64_t hashKeyParts(std::string_view key) {
+    return hashKeyParts(key, std::string_view());
+}
+
+#endif
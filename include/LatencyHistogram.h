@@ -0,0 +1,89 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+
+// HDR-style latency histogram over nanoseconds.
+//
+// Values below 2 * SUB_BUCKETS are counted exactly; above that every power
+// of two is split into SUB_BUCKETS linear buckets, so a reported value is
+// at most 1/SUB_BUCKETS (about 1.6%) above the true one, from nanoseconds
+// to hours, in a fixed 30 KB of counters. Recording is a few shifts and
+// one increment.
+class LatencyHistogram {
+private:
+    static constexpr unsigned SUB_BUCKET_BITS = 6;
+    static constexpr uint64_t SUB_BUCKETS = uint64_t(1) << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    std::array<uint64_t, BUCKETS> counts{};
+    uint64_t total = 0;
+    uint64_t maxValue = 0;
+    uint64_t sum = 0;
+
+    static size_t indexOf(uint64_t value) {
+        if (value < 2 * SUB_BUCKETS) return static_cast<size_t>(value);
+        // value >> shift lands in [SUB_BUCKETS, 2 * SUB_BUCKETS)
+        unsigned shift = 63 - __builtin_clzll(value) - SUB_BUCKET_BITS;
+        return shift * SUB_BUCKETS + (value >> shift);
+    }
+
+    // Largest value that falls into bucket `index`
+    static uint64_t highestValueOf(size_t index) {
+        if (index < 2 * SUB_BUCKETS) return index;
+        unsigned shift = static_cast<unsigned>(index / SUB_BUCKETS - 1);
+        uint64_t sub = index - shift * SUB_BUCKETS;
+        return ((sub + 1) << shift) - 1;
+    }
+
+public:
+    void record(uint64_t nanoseconds) {
+        counts[indexOf(nanoseconds)]++;
+        total++;
+        sum += nanoseconds;
+        maxValue = std::max(maxValue, nanoseconds);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < BUCKETS; i++) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        sum += other.sum;
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+
+    void clear() {
+        counts.fill(0);
+        total = 0;
+        sum = 0;
+        maxValue = 0;
+    }
+
+    uint64_t count() const { return total; }
+
+    uint64_t max() const { return maxValue; }
+
+    double mean() const {
+        return total > 0 ? static_cast<double>(sum) / total : 0.0;
+    }
+
+    // Smallest recorded value (bucket upper bound) with at least `percentile`
+    // percent of the values at or below it; 0 when empty
+    uint64_t percentile(double percentile) const {
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * total));
+        rank = std::clamp<uint64_t>(rank, 1, total);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            seen += counts[i];
+            if (seen >= rank) return std::min(highestValueOf(i), maxValue);
+        }
+        return maxValue;
+    }
+};
+
+#endif
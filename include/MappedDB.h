@@ -0,0 +1,143 @@
+#ifndef MAPPED_DB_H
+#define MAPPED_DB_H
+
+#include "Database.h"
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+// Variant 8: queries served straight from a snapshot
+// loadSnapshot maps the file and validates it (one sequential pass for the
+// checksum and the bounds checks). From then on getRow views, name lookups
+// and email lookups read the mapped records, string heap and hash tables
+// (see Snapshot.h), so a warm start parses, copies and hashes nothing.
+// loadFromFile builds the same image in memory. The image is read-only:
+// updated groups live in an overlay by row, each distinct group stored once.
+class MappedDB : public IDatabase {
+private:
+    std::unique_ptr<SnapshotReader> image;
+    std::unordered_map<size_t, std::string_view> updatedGroups;
+    std::unordered_set<std::string> groupNames;
+
+    std::string_view groupOf(size_t row) const {
+        if (!updatedGroups.empty()) {
+            auto it = updatedGroups.find(row);
+            if (it != updatedGroups.end()) return it->second;
+        }
+        return image->string(image->record(row).group);
+    }
+
+    void clearUpdates() {
+        updatedGroups.clear();
+        groupNames.clear();
+    }
+
+public:
+    MappedDB() : image(SnapshotReader::fromImage(SnapshotWriter().image())) {}
+
+    void loadFromFile(const std::string& filename) override {
+        CsvReader reader(filename);
+        AllocationScope scope(AllocationTag::Students);
+
+        // Rows are viewed in the mapped CSV; of several rows with one email the last wins
+        SnapshotWriter writer;
+        std::unordered_map<std::string_view, size_t> emailRows;
+        size_t row = 0;
+        reader.forEachLine([&](std::string_view line) {
+            StudentView s = StudentView::fromCSV(line);
+            writer.addStudent(s);
+            emailRows[s.m_email] = row++;
+        });
+        for (const auto& [email, emailRow] : emailRows) {
+            writer.addEmailRow(emailRow);
+        }
+
+        std::string built = writer.image();
+        if (built.empty()) throw std::length_error("Dataset too large for a snapshot image: " + filename);
+        image = SnapshotReader::fromImage(std::move(built));
+        clearUpdates();
+    }
+
+    bool saveSnapshot(const std::string& filename) const override {
+        SnapshotWriter writer;
+        for (size_t row = 0; row < rowCount(); row++) {
+            writer.addStudent(getRow(row));
+        }
+        std::vector<size_t> rows;
+        for (size_t i = 0; i < image->nameEntryCount(); i++) {
+            rows.assign(image->namePostingsBegin(i), image->namePostingsEnd(i));
+            writer.addNameEntry(rows);
+        }
+        for (size_t i = 0; i < image->emailEntryCount(); i++) {
+            writer.addEmailRow(image->emailRow(i));
+        }
+        return writer.write(filename);
+    }
+
+    // The file stays mapped until the next load
+    bool loadSnapshot(const std::string& filename) override {
+        auto mapped = std::make_unique<SnapshotReader>(filename);
+        if (!mapped->isValid()) return false;
+        image = std::move(mapped);
+        clearUpdates();
+        return true;
+    }
+
+    RowSpan findRowsByNameSurname(const std::string& name, const std::string& surname,
+                                  std::vector<size_t>& scratch) const override {
+        size_t entry = image->findNameEntry(name, surname);
+        if (entry == SNAPSHOT_NOT_FOUND) return RowSpan();
+        // Postings are 32-bit in the image, RowSpan holds size_t
+        scratch.assign(image->namePostingsBegin(entry), image->namePostingsEnd(entry));
+        return RowSpan(scratch);
+    }
+
+    std::set<std::string> findGroupsWithDuplicateNameSurname() override {
+        std::set<std::string> result;
+        std::set<std::string_view> groups;
+        for (size_t i = 0; i < image->nameEntryCount(); i++) {
+            if (image->namePostingsEnd(i) - image->namePostingsBegin(i) < 2) continue;
+            groups.clear();
+            for (const uint32_t* row = image->namePostingsBegin(i); row != image->namePostingsEnd(i); row++) {
+                groups.insert(groupOf(*row));
+            }
+            if (groups.size() > 1) {
+                result.insert(groups.begin(), groups.end());
+            }
+        }
+        return result;
+    }
+
+    bool updateGroupByEmail(const std::string& email, const std::string& newGroup) override {
+        size_t row = image->findEmailRow(email);
+        if (row == SNAPSHOT_NOT_FOUND) return false;
+        AllocationScope scope(AllocationTag::Other);
+        updatedGroups[row] = *groupNames.insert(newGroup).first;
+        return true;
+    }
+
+    size_t rowCount() const override {
+        return image->rowCount();
+    }
+
+    StudentView getRow(size_t row) const override {
+        StudentView s = image->view(row);
+        s.m_group = groupOf(row);
+        return s;
+    }
+
+    // The image (mapped or in memory) plus the update overlay
+    size_t getMemoryUsage() const override {
+        const size_t nodeOverhead = 2 * sizeof(void*) + sizeof(size_t);
+        size_t size = image->byteSize();
+        size += updatedGroups.size() * (nodeOverhead + sizeof(size_t) + sizeof(std::string_view));
+        for (const auto& group : groupNames) {
+            size += nodeOverhead + sizeof(std::string) + group.capacity();
+        }
+        return size;
+    }
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "AllocationCounter.h"
+#include <vector>
+#include <thread>
+#include <cstdint>
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+// Runs fn(0) .. fn(threads - 1) concurrently; fn(0) runs on the calling thread.
+// Workers allocate under the caller's AllocationTag.
+template <typename Fn>
+void parallelFor(size_t threads, Fn fn) {
+    std::vector<std::thread> workers;
+    AllocationTag tag = AllocationCounter::currentTag;
+    for (size_t t = 1; t < threads; t++) {
+        workers.emplace_back([fn, tag, t]() mutable {
+            AllocationScope scope(tag);
+            fn(t);
+        });
+    }
+    if (threads > 0) fn(0);
+    for (auto& w : workers) {
+        w.join();
+    }
+}
+
+// Hardware thread count, never 0
+inline size_t hardwareThreads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Runs fn(task) for every task in [0, tasks) on up to `threads` workers.
+// Tasks are dealt round-robin to per-worker queues; a worker takes from the
+// front of its own queue and, once that is empty, steals from the back of
+// the others, so a few large tasks do not leave the rest of the pool idle.
+// Number tasks largest first for the best balance.
+template <typename Fn>
+void parallelForEachTask(size_t tasks, size_t threads, Fn fn) {
+    threads = std::max<size_t>(1, std::min(threads, tasks));
+
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+    std::unique_ptr<Queue[]> queues(new Queue[threads]);
+    for (size_t task = 0; task < tasks; task++) {
+        queues[task % threads].tasks.push_back(task);
+    }
+
+    parallelFor(threads, [&](size_t t) {
+        for (;;) {
+            size_t task = 0;
+            bool found = false;
+            {
+                std::lock_guard lock(queues[t].mutex);
+                if (!queues[t].tasks.empty()) {
+                    task = queues[t].tasks.front();
+                    queues[t].tasks.pop_front();
+                    found = true;
+                }
+            }
+            for (size_t k = 1; !found && k < threads; k++) {
+                Queue& victim = queues[(t + k) % threads];
+                std::lock_guard lock(victim.mutex);
+                if (!victim.tasks.empty()) {
+                    task = victim.tasks.back();
+                    victim.tasks.pop_back();
+                    found = true;
+                }
+            }
+            // Tasks never spawn tasks, so empty queues everywhere means done
+            if (!found) return;
+            fn(task);
+        }
+    });
+}
+
+// Builds an index with `threads` workers.
+// partOf(i) picks the worker that owns row i (equal keys must map to the same
+// worker), and each worker calls insert(localIndex, i) for its rows in row
+// order, so the per-key contents match a serial build. The private indexes
+// hold disjoint keys and are spliced into `index` without copying nodes.
+template <typename Map, typename PartFn, typename InsertFn>
+void buildPartitionedIndex(Map& index, size_t rows, size_t threads, PartFn partOf, InsertFn insert) {
+    threads = std::max<size_t>(1, std::min<size_t>(threads, UINT16_MAX));
+
+    std::vector<uint16_t> owner(rows);
+    parallelFor(threads, [&](size_t t) {
+        size_t begin = rows * t / threads;
+        size_t end = rows * (t + 1) / threads;
+        for (size_t i = begin; i < end; i++) {
+            owner[i] = static_cast<uint16_t>(partOf(i) % threads);
+        }
+    });
+
+    std::vector<Map> locals(threads);
+    parallelFor(threads, [&](size_t t) {
+        for (size_t i = 0; i < rows; i++) {
+            if (owner[i] == t) insert(locals[t], i);
+        }
+    });
+
+    for (auto& local : locals) {
+        index.merge(local);
+    }
+}
+
+#endif
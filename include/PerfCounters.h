@@ -0,0 +1,126 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Events counted by PerfCounters, in CSV column order
+enum class PerfEvent : uint8_t {
+    Cycles,
+    Instructions,
+    L1Misses,      // L1 data cache read misses
+    LlcMisses,     // last level cache misses
+    BranchMisses,
+    PageFaults,
+    Count
+};
+
+constexpr size_t PERF_EVENTS = static_cast<size_t>(PerfEvent::Count);
+constexpr const char* PERF_EVENT_LABELS[PERF_EVENTS] = {
+    "Cycles", "Instructions", "L1Misses", "LlcMisses", "BranchMisses", "PageFaults"};
+
+// Counter values at one point, or the difference of two; an event that
+// could not be counted is invalid in every reading
+struct PerfReading {
+    std::array<double, PERF_EVENTS> values{};
+    std::array<bool, PERF_EVENTS> valid{};
+
+    PerfReading operator-(const PerfReading& other) const {
+        PerfReading delta;
+        for (size_t i = 0; i < PERF_EVENTS; i++) {
+            delta.values[i] = values[i] - other.values[i];
+            delta.valid[i] = valid[i] && other.valid[i];
+        }
+        return delta;
+    }
+
+    PerfReading& operator+=(const PerfReading& other) {
+        for (size_t i = 0; i < PERF_EVENTS; i++) {
+            values[i] += other.values[i];
+            valid[i] = valid[i] && other.valid[i];
+        }
+        return *this;
+    }
+
+    double operator[](PerfEvent event) const {
+        return values[static_cast<size_t>(event)];
+    }
+
+    bool has(PerfEvent event) const {
+        return valid[static_cast<size_t>(event)];
+    }
+};
+
+// User-space event counts of the calling thread via perf_event_open.
+//
+// Every event is opened on its own, so the ones the CPU, a VM or
+// perf_event_paranoid do not allow are just missing from the readings
+// (virtual machines often expose page faults only); available() is false
+// when none could be opened. The counters run from construction on and are
+// read twice around a region, which costs one read() per event. When the
+// kernel had to multiplex a counter, its count is scaled to the full time.
+class PerfCounters {
+private:
+    std::array<int, PERF_EVENTS> fds;
+
+    static int open(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+public:
+    PerfCounters() {
+        const uint64_t l1ReadMiss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        fds[static_cast<size_t>(PerfEvent::Cycles)] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds[static_cast<size_t>(PerfEvent::Instructions)] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fds[static_cast<size_t>(PerfEvent::L1Misses)] = open(PERF_TYPE_HW_CACHE, l1ReadMiss);
+        fds[static_cast<size_t>(PerfEvent::LlcMisses)] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        fds[static_cast<size_t>(PerfEvent::BranchMisses)] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        fds[static_cast<size_t>(PerfEvent::PageFaults)] = open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+    }
+
+    ~PerfCounters() {
+        for (int fd : fds) {
+            if (fd >= 0) close(fd);
+        }
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const {
+        for (int fd : fds) {
+            if (fd >= 0) return true;
+        }
+        return false;
+    }
+
+    bool has(PerfEvent event) const {
+        return fds[static_cast<size_t>(event)] >= 0;
+    }
+
+    PerfReading read() const {
+        PerfReading reading;
+        for (size_t i = 0; i < PERF_EVENTS; i++) {
+            uint64_t data[3];  // value, time enabled, time running
+            if (fds[i] < 0 || ::read(fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0) continue;
+            reading.values[i] = data[2] < data[1] ? static_cast<double>(data[0]) * data[1] / data[2] : data[0];
+            reading.valid[i] = true;
+        }
+        return reading;
+    }
+};
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef PERFECT_HASH_INDEX_H
+#define PERFECT_HASH_INDEX_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+// Static index over a key set that never changes after it is built, as a
+// minimal perfect hash in the style of BBHash.
+//
+// Level l is a bit array of about GAMMA bits per key still unplaced. Each
+// key hashes to one bit per level; keys alone on their bit set it and are
+// placed, colliding keys move on to the next, smaller level. A key's slot
+// is the rank of its bit among all set bits, so the n keys map to slots
+// 0..n-1 with no empty slot. That costs about 3 bits per key, plus a rank
+// entry per 512 bits, one 8-bit fingerprint and the 32-bit value per slot.
+//
+// Like FlatHashIndex, keys are not stored: callers pass the key hash and
+// an equality test on a candidate value. A lookup usually probes one bit,
+// and the fingerprint rejects 255 of 256 absent keys before the equality
+// test has to look at the row. Keys whose 64-bit hashes are equal
+// (practically never) collide on every level and end up in a small sorted
+// fallback array.
+class PerfectHashIndex {
+private:
+    static constexpr double GAMMA = 2.0;
+    static constexpr size_t MAX_LEVELS = 32;
+    static constexpr size_t RANK_WORDS = 8;  // one rank entry per 512 bits
+
+    struct Entry {
+        uint64_t hash;
+        uint32_t value;
+    };
+
+    std::vector<uint64_t> bits;          // every level's bit array, one after another
+    std::vector<uint32_t> ranks;         // set bits before each 512-bit block
+    std::vector<size_t> levelOffsets;    // first bit of each level, plus the total
+    std::vector<uint32_t> slots;         // slot -> value
+    std::vector<uint8_t> fingerprints;   // slot -> top 8 bits of the key hash
+    std::vector<Entry> fallback;         // sorted by hash
+
+    static uint8_t fingerprint(uint64_t hash) { return static_cast<uint8_t>(hash >> 56); }
+
+    // Bit of the key in a level of `size` bits
+    static size_t position(uint64_t hash, size_t level, size_t size) {
+        uint64_t h = hash + (level + 1) * 0x9e3779b97f4a7c15ULL;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return static_cast<size_t>((static_cast<unsigned __int128>(h) * size) >> 64);
+    }
+
+    bool testBit(size_t bit) const {
+        return (bits[bit / 64] >> (bit % 64)) & 1;
+    }
+
+    size_t rank(size_t bit) const {
+        size_t word = bit / 64;
+        size_t result = ranks[word / RANK_WORDS];
+        for (size_t w = word / RANK_WORDS * RANK_WORDS; w < word; w++) {
+            result += __builtin_popcountll(bits[w]);
+        }
+        return result + __builtin_popcountll(bits[word] & ((uint64_t(1) << (bit % 64)) - 1));
+    }
+
+public:
+    size_t size() const { return slots.size() + fallback.size(); }
+
+    void clear() {
+        bits.clear();
+        ranks.clear();
+        levelOffsets.clear();
+        slots.clear();
+        fingerprints.clear();
+        fallback.clear();
+    }
+
+    // Builds the index over values 0..n-1. hashOf(value) is the hash of the
+    // value's key and sameKey(a, b) compares the keys of two values; of
+    // values with the same key the largest is kept, as later rows win in
+    // the other email indexes.
+    template <typename HashOf, typename SameKey>
+    void build(size_t n, HashOf hashOf, SameKey sameKey) {
+        clear();
+
+        std::vector<Entry> entries(n);
+        for (size_t i = 0; i < n; i++) {
+            entries[i] = {hashOf(static_cast<uint32_t>(i)), static_cast<uint32_t>(i)};
+        }
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.hash != b.hash ? a.hash < b.hash : a.value < b.value;
+        });
+
+        // One entry per distinct key: equal keys sit in runs of equal hashes
+        std::vector<Entry> remaining;
+        remaining.reserve(n);
+        for (size_t begin = 0, end; begin < n; begin = end) {
+            size_t first = remaining.size();
+            for (end = begin; end < n && entries[end].hash == entries[begin].hash; end++) {
+                auto same = std::find_if(remaining.begin() + first, remaining.end(), [&](const Entry& e) {
+                    return sameKey(e.value, entries[end].value);
+                });
+                if (same != remaining.end()) {
+                    same->value = entries[end].value;
+                } else {
+                    remaining.push_back(entries[end]);
+                }
+            }
+        }
+        std::vector<Entry>().swap(entries);
+
+        std::vector<std::pair<size_t, Entry>> placed;  // global bit, entry
+        placed.reserve(remaining.size());
+        std::vector<uint64_t> collisions;
+        std::vector<Entry> next;
+        size_t totalBits = 0;
+        for (size_t level = 0; !remaining.empty() && level < MAX_LEVELS; level++) {
+            size_t levelBits = std::max<size_t>(64, static_cast<size_t>(GAMMA * remaining.size()) + 63) / 64 * 64;
+            levelOffsets.push_back(totalBits);
+            bits.resize((totalBits + levelBits) / 64, 0);
+            uint64_t* levelWords = bits.data() + totalBits / 64;
+            collisions.assign(levelBits / 64, 0);
+
+            for (const Entry& e : remaining) {
+                size_t p = position(e.hash, level, levelBits);
+                uint64_t mask = uint64_t(1) << (p % 64);
+                if (levelWords[p / 64] & mask) collisions[p / 64] |= mask;
+                levelWords[p / 64] |= mask;
+            }
+            for (size_t w = 0; w < collisions.size(); w++) {
+                levelWords[w] &= ~collisions[w];
+            }
+
+            next.clear();
+            for (const Entry& e : remaining) {
+                size_t p = position(e.hash, level, levelBits);
+                if ((collisions[p / 64] >> (p % 64)) & 1) {
+                    next.push_back(e);
+                } else {
+                    placed.emplace_back(totalBits + p, e);
+                }
+            }
+            remaining.swap(next);
+            totalBits += levelBits;
+        }
+        levelOffsets.push_back(totalBits);
+        fallback = remaining;
+
+        ranks.resize(bits.size() / RANK_WORDS + 1);
+        uint32_t setBits = 0;
+        for (size_t w = 0; w < bits.size(); w++) {
+            if (w % RANK_WORDS == 0) ranks[w / RANK_WORDS] = setBits;
+            setBits += __builtin_popcountll(bits[w]);
+        }
+
+        slots.resize(placed.size());
+        fingerprints.resize(placed.size());
+        for (const auto& [bit, e] : placed) {
+            size_t slot = rank(bit);
+            slots[slot] = e.value;
+            fingerprints[slot] = fingerprint(e.hash);
+        }
+    }
+
+    // Hint to pull the key's first-level bit into cache
+    void prefetch(uint64_t hash) const {
+        if (levelOffsets.size() < 2) return;
+        __builtin_prefetch(bits.data() + position(hash, 0, levelOffsets[1]) / 64);
+    }
+
+    // Value whose key equals the probed one (eq(value) tells), or nullptr
+    template <typename Eq>
+    const uint32_t* find(uint64_t hash, Eq eq) const {
+        for (size_t level = 0; level + 1 < levelOffsets.size(); level++) {
+            size_t levelBits = levelOffsets[level + 1] - levelOffsets[level];
+            size_t bit = levelOffsets[level] + position(hash, level, levelBits);
+            if (!testBit(bit)) continue;
+            // The key can only be the one placed here: earlier levels left
+            // its bit clear, later ones never see it
+            size_t slot = rank(bit);
+            if (fingerprints[slot] != fingerprint(hash)) return nullptr;
+            return eq(slots[slot]) ? &slots[slot] : nullptr;
+        }
+        auto it = std::lower_bound(fallback.begin(), fallback.end(), hash,
+                                   [](const Entry& e, uint64_t h) { return e.hash < h; });
+        for (; it != fallback.end() && it->hash == hash; ++it) {
+            if (eq(it->value)) return &it->value;
+        }
+        return nullptr;
+    }
+
+    // Calls fn(value) for every stored value, in no particular order
+    template <typename Fn>
+    void forEachValue(Fn fn) const {
+        for (uint32_t value : slots) fn(value);
+        for (const Entry& e : fallback) fn(e.value);
+    }
+
+    size_t getMemoryUsage() const {
+        return bits.capacity() * sizeof(uint64_t) + ranks.capacity() * sizeof(uint32_t) +
+               levelOffsets.capacity() * sizeof(size_t) + slots.capacity() * sizeof(uint32_t) +
+               fingerprints.capacity() * sizeof(uint8_t) + fallback.capacity() * sizeof(Entry);
+    }
+};
+
+#endif
@@ -0,0 +1,266 @@
+#ifndef PIPELINED_LOADER_H
+#define PIPELINED_LOADER_H
+
+#include "Database.h"
+#include "CsvReader.h"
+#include "BoundedQueue.h"
+#include "Parallel.h"
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <exception>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Time spent in each stage of the last PipelinedLoader::load, in seconds
+struct PipelineStats {
+    double readTime = 0.0;   // reader thread inside read()
+    double parseTime = 0.0;  // parser threads parsing, summed over threads
+    double indexTime = 0.0;  // calling thread adding batches (appendLoadedRows)
+    double buildTime = 0.0;  // calling thread finishing the load (endLoad)
+    double waitTime = 0.0;   // calling thread waiting for the next parsed chunk
+    double totalTime = 0.0;
+    size_t chunks = 0;
+};
+
+// Loads a CSV file with reading, parsing and index construction overlapped.
+//
+// A reader thread read()s the file into newline aligned chunks of about
+// CHUNK_BYTES and numbers them. Parser threads take chunks from a bounded
+// lock-free queue, parse them into rows and hand the batches to the calling
+// thread through a second queue. The calling thread puts the batches back
+// in file order and feeds them to the database's streaming load
+// (beginLoad / appendLoadedRows / endLoad), so the result is the same as
+// loadFromFile, later duplicate emails winning included.
+//
+// At most MAX_IN_FLIGHT chunks exist at a time, read but not yet indexed:
+// the reader waits for the indexer before reading more, so memory stays
+// bounded by about MAX_IN_FLIGHT chunks and their rows however large the
+// file is, and neither queue can fill up.
+//
+// Variants without a streaming load (the wrappers) are loaded with
+// loadFromFile; their stats only have totalTime.
+class PipelinedLoader {
+public:
+    static constexpr size_t CHUNK_BYTES = size_t(1) << 20;
+    static constexpr size_t MAX_IN_FLIGHT = 8;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Chunk {
+        size_t seq = 0;
+        std::string text;
+    };
+
+    struct Batch {
+        size_t seq = 0;
+        std::vector<Student> rows;
+        std::exception_ptr error;
+    };
+
+    size_t parserThreads;
+    PipelineStats lastStats;
+
+    static double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // Blocking push, for queues the in-flight limit keeps from filling up
+    template <typename T>
+    static void push(BoundedQueue<T>& queue, T& value) {
+        while (!queue.tryPush(value)) {
+            std::this_thread::yield();
+        }
+    }
+
+public:
+    explicit PipelinedLoader(size_t parserThreads = hardwareThreads())
+        : parserThreads(std::max<size_t>(1, parserThreads)) {}
+
+    // Loads filename into db, replacing its contents. False if the file
+    // cannot be opened or read (db is then left empty or partly loaded).
+    // A parse error is rethrown here once the pipeline has stopped, as
+    // loadFromFile would throw it.
+    bool load(IDatabase& db, const std::string& filename) {
+        auto start = Clock::now();
+        lastStats = PipelineStats();
+
+        if (!db.beginLoad()) {
+            db.loadFromFile(filename);
+            lastStats.totalTime = secondsSince(start);
+            return true;
+        }
+
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            db.endLoad();
+            lastStats.totalTime = secondsSince(start);
+            return false;
+        }
+
+        BoundedQueue<Chunk> chunks(MAX_IN_FLIGHT);
+        BoundedQueue<Batch> batches(MAX_IN_FLIGHT);
+        std::atomic<size_t> indexed{0};      // chunks handed to the database
+        std::atomic<size_t> chunkCount{0};   // chunks read, final once readDone is set
+        std::atomic<bool> readDone{false};
+        std::atomic<bool> cancelled{false};
+        bool readFailed = false;
+        double readTime = 0.0;
+        std::vector<double> parseTimes(parserThreads, 0.0);
+
+        std::thread reader([&]() {
+            std::string carry;
+            size_t seq = 0;
+            bool eof = false;
+            while (!eof) {
+                while (seq - indexed.load(std::memory_order_acquire) >= MAX_IN_FLIGHT &&
+                       !cancelled.load(std::memory_order_relaxed)) {
+                    std::this_thread::yield();
+                }
+                if (cancelled.load(std::memory_order_relaxed)) break;
+
+                Chunk chunk;
+                chunk.seq = seq;
+                chunk.text.swap(carry);
+                // Read until the chunk is full and holds a line end, or EOF
+                auto readStart = Clock::now();
+                for (;;) {
+                    size_t used = chunk.text.size();
+                    chunk.text.resize(used + CHUNK_BYTES);
+                    ssize_t n = ::read(fd, chunk.text.data() + used, CHUNK_BYTES);
+                    chunk.text.resize(used + std::max<ssize_t>(n, 0));
+                    if (n < 0 && errno == EINTR) continue;
+                    if (n <= 0) {
+                        readFailed = n < 0;
+                        eof = true;
+                        break;
+                    }
+                    if (chunk.text.size() >= CHUNK_BYTES && chunk.text.rfind('\n') != std::string::npos) break;
+                }
+                readTime += secondsSince(readStart);
+
+                // The row cut by the chunk end moves to the next chunk
+                if (!eof) {
+                    size_t lastNewline = chunk.text.rfind('\n');
+                    carry.assign(chunk.text, lastNewline + 1);
+                    chunk.text.resize(lastNewline + 1);
+                }
+                if (seq == 0) chunk.text.erase(0, CsvReader::dataOffsetIn(chunk.text));
+                if (chunk.text.empty()) continue;
+
+                push(chunks, chunk);
+                seq++;
+            }
+            chunkCount.store(seq, std::memory_order_relaxed);
+            readDone.store(true, std::memory_order_release);
+        });
+
+        std::vector<std::thread> parsers;
+        for (size_t t = 0; t < parserThreads; t++) {
+            parsers.emplace_back([&, t]() {
+                AllocationScope scope(AllocationTag::Students);
+                Chunk chunk;
+                while (!cancelled.load(std::memory_order_relaxed)) {
+                    if (!chunks.tryPop(chunk)) {
+                        // Nothing is pushed after readDone, so an empty pop after it means done
+                        bool done = readDone.load(std::memory_order_acquire);
+                        if (!chunks.tryPop(chunk)) {
+                            if (done) return;
+                            std::this_thread::yield();
+                            continue;
+                        }
+                    }
+
+                    auto parseStart = Clock::now();
+                    Batch batch;
+                    batch.seq = chunk.seq;
+                    try {
+                        CsvReader::forEachLineIn(chunk.text, [&](std::string_view line) {
+                            batch.rows.push_back(Student::fromCSV(line));
+                        });
+                    } catch (...) {
+                        batch.rows.clear();
+                        batch.error = std::current_exception();
+                    }
+                    std::string().swap(chunk.text);
+                    parseTimes[t] += secondsSince(parseStart);
+                    push(batches, batch);
+                }
+            });
+        }
+
+        auto stop = [&]() {
+            cancelled.store(true, std::memory_order_relaxed);
+            reader.join();
+            for (auto& parser : parsers) {
+                parser.join();
+            }
+            ::close(fd);
+        };
+
+        // Indexer: batches arrive in any order and are applied in file order
+        std::vector<Batch> pending(MAX_IN_FLIGHT);
+        std::vector<bool> present(MAX_IN_FLIGHT, false);
+        size_t next = 0;
+        auto finished = [&]() {
+            return readDone.load(std::memory_order_acquire) && next == chunkCount.load(std::memory_order_relaxed);
+        };
+        try {
+            while (!finished()) {
+                size_t at = next % MAX_IN_FLIGHT;
+                if (present[at]) {
+                    if (pending[at].error) std::rethrow_exception(pending[at].error);
+                    auto indexStart = Clock::now();
+                    db.appendLoadedRows(pending[at].rows);
+                    lastStats.indexTime += secondsSince(indexStart);
+                    present[at] = false;
+                    next++;
+                    indexed.store(next, std::memory_order_release);
+                    continue;
+                }
+
+                auto waitStart = Clock::now();
+                Batch batch;
+                bool popped;
+                while (!(popped = batches.tryPop(batch)) && !finished()) {
+                    std::this_thread::yield();
+                }
+                lastStats.waitTime += secondsSince(waitStart);
+                if (!popped) break;
+                at = batch.seq % MAX_IN_FLIGHT;
+                pending[at] = std::move(batch);
+                present[at] = true;
+            }
+        } catch (...) {
+            stop();
+            throw;
+        }
+        stop();
+
+        auto buildStart = Clock::now();
+        db.endLoad();
+        lastStats.buildTime = secondsSince(buildStart);
+
+        lastStats.readTime = readTime;
+        for (double parseTime : parseTimes) {
+            lastStats.parseTime += parseTime;
+        }
+        lastStats.chunks = next;
+        lastStats.totalTime = secondsSince(start);
+        return !readFailed;
+    }
+
+    const PipelineStats& stats() const {
+        return lastStats;
+    }
+
+    size_t threadCount() const {
+        return parserThreads;
+    }
+};
+
+#endif
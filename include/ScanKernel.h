@@ -0,0 +1,107 @@
+#ifndef SCAN_KERNEL_H
+#define SCAN_KERNEL_H
+
+#include <cstdint>
+#include <cstddef>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_KERNEL_X86 1
+#endif
+
+// Equality scan over a packed column of 32-bit values.
+//
+// findEqual(column, n, value, matches) writes the index of every i < n with
+// column[i] == value to matches (room for n entries) and returns the count.
+// The AVX2 and SSE2 kernels are compiled with target attributes, so one
+// binary carries all of them; selectScanKernel() picks the widest one the
+// CPU supports at runtime.
+using ScanKernel = size_t (*)(const uint32_t* column, size_t n, uint32_t value, uint32_t* matches);
+
+inline size_t findEqualScalar(const uint32_t* column, size_t n, uint32_t value, uint32_t* matches) {
+    size_t found = 0;
+    for (size_t i = 0; i < n; i++) {
+        matches[found] = static_cast<uint32_t>(i);
+        found += column[i] == value;
+    }
+    return found;
+}
+
+#ifdef SCAN_KERNEL_X86
+// Matches are rare, so test 16 (SSE2) or 32 (AVX2) rows at once and only
+// extract positions from blocks that hit
+__attribute__((target("sse2")))
+inline size_t findEqualSse2(const uint32_t* column, size_t n, uint32_t value, uint32_t* matches) {
+    size_t found = 0;
+    size_t i = 0;
+    const __m128i needle = _mm_set1_epi32(static_cast<int>(value));
+    for (; i + 16 <= n; i += 16) {
+        const __m128i* block = reinterpret_cast<const __m128i*>(column + i);
+        __m128i e0 = _mm_cmpeq_epi32(_mm_loadu_si128(block), needle);
+        __m128i e1 = _mm_cmpeq_epi32(_mm_loadu_si128(block + 1), needle);
+        __m128i e2 = _mm_cmpeq_epi32(_mm_loadu_si128(block + 2), needle);
+        __m128i e3 = _mm_cmpeq_epi32(_mm_loadu_si128(block + 3), needle);
+        __m128i any = _mm_or_si128(_mm_or_si128(e0, e1), _mm_or_si128(e2, e3));
+        if (_mm_movemask_epi8(any) == 0) continue;
+
+        uint32_t mask = _mm_movemask_ps(_mm_castsi128_ps(e0)) |
+                        (_mm_movemask_ps(_mm_castsi128_ps(e1)) << 4) |
+                        (_mm_movemask_ps(_mm_castsi128_ps(e2)) << 8) |
+                        (_mm_movemask_ps(_mm_castsi128_ps(e3)) << 12);
+        for (; mask != 0; mask &= mask - 1) {
+            matches[found++] = static_cast<uint32_t>(i + __builtin_ctz(mask));
+        }
+    }
+    for (; i < n; i++) {
+        matches[found] = static_cast<uint32_t>(i);
+        found += column[i] == value;
+    }
+    return found;
+}
+
+__attribute__((target("avx2")))
+inline size_t findEqualAvx2(const uint32_t* column, size_t n, uint32_t value, uint32_t* matches) {
+    size_t found = 0;
+    size_t i = 0;
+    const __m256i needle = _mm256_set1_epi32(static_cast<int>(value));
+    for (; i + 32 <= n; i += 32) {
+        const __m256i* block = reinterpret_cast<const __m256i*>(column + i);
+        __m256i e0 = _mm256_cmpeq_epi32(_mm256_loadu_si256(block), needle);
+        __m256i e1 = _mm256_cmpeq_epi32(_mm256_loadu_si256(block + 1), needle);
+        __m256i e2 = _mm256_cmpeq_epi32(_mm256_loadu_si256(block + 2), needle);
+        __m256i e3 = _mm256_cmpeq_epi32(_mm256_loadu_si256(block + 3), needle);
+        __m256i any = _mm256_or_si256(_mm256_or_si256(e0, e1), _mm256_or_si256(e2, e3));
+        if (_mm256_testz_si256(any, any)) continue;
+
+        uint32_t mask = _mm256_movemask_ps(_mm256_castsi256_ps(e0)) |
+                        (_mm256_movemask_ps(_mm256_castsi256_ps(e1)) << 8) |
+                        (_mm256_movemask_ps(_mm256_castsi256_ps(e2)) << 16) |
+                        (static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(e3))) << 24);
+        for (; mask != 0; mask &= mask - 1) {
+            matches[found++] = static_cast<uint32_t>(i + __builtin_ctz(mask));
+        }
+    }
+    for (; i < n; i++) {
+        matches[found] = static_cast<uint32_t>(i);
+        found += column[i] == value;
+    }
+    return found;
+}
+#endif
+
+inline ScanKernel selectScanKernel() {
+#ifdef SCAN_KERNEL_X86
+    if (__builtin_cpu_supports("avx2")) return findEqualAvx2;
+    if (__builtin_cpu_supports("sse2")) return findEqualSse2;
+#endif
+    return findEqualScalar;
+}
+
+inline const char* scanKernelName(ScanKernel kernel) {
+#ifdef SCAN_KERNEL_X86
+    if (kernel == findEqualAvx2) return "avx2";
+    if (kernel == findEqualSse2) return "sse2";
+#endif
+    return "scalar";
+}
+
+#endif
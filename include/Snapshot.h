@@ -0,0 +1,528 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "Student.h"
+#include <string>
+#include <string_view>
+#include <memory>
+#include <cstdio>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Binary snapshot of a loaded database.
+//
+// Layout (native endianness, every section 8 byte aligned):
+//   SnapshotHeader
+//   string heap        - raw bytes of every string field
+//   SnapshotRecord[]   - one fixed-width record per student, in row order
+//   SnapshotNameEntry[] - one entry per name|surname key of the name index
+//   uint32_t[]         - name index postings (row ids), referenced by entries
+//   uint32_t[]         - email index: row id per distinct email
+//   SnapshotSlot[]     - hash table of the name entries
+//   SnapshotSlot[]     - hash table of the email rows
+//
+// Index keys are not stored: a key is the name/surname or email of the first
+// row it points to. The two hash tables use open addressing with linear
+// probing and are at most half full, so a lookup can run on the mapped file
+// as it is (see SnapshotReader::findEmailRow / findNameEntry). The checksum
+// covers everything after the header. Offsets, lengths and row ids are 32
+// bit; SnapshotWriter refuses data that does not fit.
+
+const char SNAPSHOT_MAGIC[8] = {'S', 'T', 'D', 'B', 'S', 'N', 'A', 'P'};
+const uint32_t SNAPSHOT_VERSION = 2;
+const size_t SNAPSHOT_NOT_FOUND = static_cast<size_t>(-1);
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t rowCount;
+    uint64_t heapSize;
+    uint64_t nameEntryCount;
+    uint64_t namePostingCount;
+    uint64_t emailEntryCount;
+    uint64_t nameSlotCount;
+    uint64_t emailSlotCount;
+    uint64_t checksum;
+};
+
+struct SnapshotString {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct SnapshotRecord {
+    SnapshotString name;
+    SnapshotString surname;
+    SnapshotString email;
+    SnapshotString group;
+    SnapshotString phoneNumber;
+    int32_t birthYear;
+    int32_t birthMonth;
+    int32_t birthDay;
+    float rating;
+};
+
+struct SnapshotNameEntry {
+    uint32_t postingStart;
+    uint32_t postingCount;
+};
+
+// Hash table slot: the top 32 bits of the key hash, so most mismatches are
+// rejected without reading the key, and the entry or row id plus one
+// (0 marks an empty slot)
+struct SnapshotSlot {
+    uint32_t tag;
+    uint32_t value;
+};
+
+inline size_t snapshotAlign(size_t size) {
+    return (size + 7) & ~size_t(7);
+}
+
+// FNV-1a style hash over 8 byte words, continuing from hash
+inline uint64_t snapshotHashBytes(uint64_t hash, const char* data, size_t size) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * 1099511628211ULL;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+inline uint64_t snapshotChecksum(const char* data, size_t size) {
+    return snapshotHashBytes(14695981039346656037ULL, data, size);
+}
+
+// Hash of a table key. It is part of the file format, so unlike
+// hashKeyParts it must not depend on the standard library's std::hash.
+// The part lengths are mixed in, so "ab"+"c" and "a"+"bc" differ.
+inline uint64_t snapshotKeyHash(std::string_view first, std::string_view second = std::string_view()) {
+    uint64_t h = snapshotHashBytes(14695981039346656037ULL, first.data(), first.size());
+    h = (h ^ first.size()) * 1099511628211ULL;
+    h = snapshotHashBytes(h, second.data(), second.size());
+    h = (h ^ second.size()) * 1099511628211ULL;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Slots of a table for count keys: a power of two, at least twice count
+inline size_t snapshotSlotCount(size_t count) {
+    size_t slots = 2;
+    while (slots < 2 * count) slots *= 2;
+    return slots;
+}
+
+// Index of the slot holding a key equal to the one hashed, or of the empty
+// slot where it would go; equals(id) compares the key with that of an entry
+// or row id. slotCount is a power of two and some slot is empty.
+template <typename Equals>
+inline size_t snapshotProbe(const SnapshotSlot* slots, size_t slotCount, uint64_t hash, Equals equals) {
+    uint32_t tag = static_cast<uint32_t>(hash >> 32);
+    size_t mask = slotCount - 1;
+    for (size_t i = static_cast<size_t>(hash) & mask;; i = (i + 1) & mask) {
+        const SnapshotSlot& slot = slots[i];
+        if (slot.value == 0 || (slot.tag == tag && equals(slot.value - 1))) return i;
+    }
+}
+
+class SnapshotWriter {
+private:
+    std::string heap;
+    std::vector<SnapshotRecord> records;
+    std::vector<SnapshotNameEntry> nameEntries;
+    std::vector<uint32_t> namePostings;
+    std::vector<uint32_t> emailRows;
+    bool overflowed = false;  // some offset, length or id did not fit in 32 bits
+
+    uint32_t narrow(size_t value) {
+        if (value > UINT32_MAX) overflowed = true;
+        return static_cast<uint32_t>(value);
+    }
+
+    SnapshotString addString(std::string_view value) {
+        SnapshotString ref{narrow(heap.size()), narrow(value.size())};
+        heap += value;
+        narrow(heap.size());
+        return ref;
+    }
+
+    std::string_view string(const SnapshotString& ref) const {
+        return std::string_view(heap.data() + ref.offset, ref.length);
+    }
+
+    bool sameName(uint32_t a, uint32_t b) const {
+        return string(records[a].name) == string(records[b].name) &&
+               string(records[a].surname) == string(records[b].surname);
+    }
+
+    uint64_t nameHash(uint32_t row) const {
+        return snapshotKeyHash(string(records[row].name), string(records[row].surname));
+    }
+
+    // Table over count ids, hashOf(id) giving the key hash of each
+    template <typename HashOf, typename Equals>
+    static std::vector<SnapshotSlot> buildTable(size_t count, HashOf hashOf, Equals equals) {
+        std::vector<SnapshotSlot> table(snapshotSlotCount(count), SnapshotSlot{0, 0});
+        for (size_t id = 0; id < count; id++) {
+            uint64_t hash = hashOf(id);
+            size_t at = snapshotProbe(table.data(), table.size(), hash, [&](uint32_t other) { return equals(id, other); });
+            table[at] = {static_cast<uint32_t>(hash >> 32), static_cast<uint32_t>(id + 1)};
+        }
+        return table;
+    }
+
+    // Name entries for a variant without a name index: rows grouped by
+    // name|surname, keys in order of first appearance, postings in row order
+    void groupNames() {
+        std::vector<SnapshotSlot> table(snapshotSlotCount(records.size()), SnapshotSlot{0, 0});
+        std::vector<uint32_t> firstRow;
+        std::vector<uint32_t> entryOf(records.size());
+        for (uint32_t row = 0; row < records.size(); row++) {
+            uint64_t hash = nameHash(row);
+            size_t at = snapshotProbe(table.data(), table.size(), hash,
+                                      [&](uint32_t entry) { return sameName(firstRow[entry], row); });
+            if (table[at].value == 0) {
+                table[at] = {static_cast<uint32_t>(hash >> 32), static_cast<uint32_t>(firstRow.size() + 1)};
+                firstRow.push_back(row);
+                nameEntries.push_back({0, 0});
+            }
+            entryOf[row] = table[at].value - 1;
+            nameEntries[entryOf[row]].postingCount++;
+        }
+        uint32_t start = 0;
+        for (auto& entry : nameEntries) {
+            entry.postingStart = start;
+            start += entry.postingCount;
+            entry.postingCount = 0;
+        }
+        namePostings.resize(records.size());
+        for (uint32_t row = 0; row < records.size(); row++) {
+            SnapshotNameEntry& entry = nameEntries[entryOf[row]];
+            namePostings[entry.postingStart + entry.postingCount++] = row;
+        }
+    }
+
+    template <typename T>
+    static void appendSection(std::string& out, const std::vector<T>& items) {
+        out.append(reinterpret_cast<const char*>(items.data()), items.size() * sizeof(T));
+        out.resize(snapshotAlign(out.size()), '\0');
+    }
+
+public:
+    void addStudent(const StudentView& s) {
+        // Ids are stored plus one in the hash tables, so the last id is reserved
+        if (records.size() >= UINT32_MAX) overflowed = true;
+        SnapshotRecord r;
+        r.name = addString(s.m_name);
+        r.surname = addString(s.m_surname);
+        r.email = addString(s.m_email);
+        r.group = addString(s.m_group);
+        r.phoneNumber = addString(s.m_phone_number);
+        r.birthYear = s.m_birth_year;
+        r.birthMonth = s.m_birth_month;
+        r.birthDay = s.m_birth_day;
+        r.rating = s.m_rating;
+        records.push_back(r);
+    }
+
+    // Rows of one name|surname key, in index order. A variant that adds no
+    // entries gets them from the rows.
+    template <typename Rows>
+    void addNameEntry(const Rows& rows) {
+        nameEntries.push_back({narrow(namePostings.size()), narrow(rows.size())});
+        for (size_t row : rows) {
+            namePostings.push_back(narrow(row));
+        }
+        narrow(namePostings.size());
+    }
+
+    // Row of one distinct email
+    void addEmailRow(size_t row) {
+        emailRows.push_back(narrow(row));
+    }
+
+    // The whole file, or an empty string if the data does not fit the format
+    std::string image() {
+        if (overflowed) return std::string();
+        if (nameEntries.empty()) groupNames();
+
+        std::vector<SnapshotSlot> nameSlots = buildTable(nameEntries.size(),
+            [&](size_t entry) { return nameHash(namePostings[nameEntries[entry].postingStart]); },
+            [&](size_t a, uint32_t b) {
+                return sameName(namePostings[nameEntries[a].postingStart], namePostings[nameEntries[b].postingStart]);
+            });
+        std::vector<SnapshotSlot> emailSlots = buildTable(emailRows.size(),
+            [&](size_t i) { return snapshotKeyHash(string(records[emailRows[i]].email)); },
+            [&](size_t, uint32_t) { return false; });
+        // Email slots hold row ids, not positions in emailRows
+        for (auto& slot : emailSlots) {
+            if (slot.value != 0) slot.value = emailRows[slot.value - 1] + 1;
+        }
+
+        std::string out(sizeof(SnapshotHeader), '\0');
+        out += heap;
+        out.resize(snapshotAlign(out.size()), '\0');
+        appendSection(out, records);
+        appendSection(out, nameEntries);
+        appendSection(out, namePostings);
+        appendSection(out, emailRows);
+        appendSection(out, nameSlots);
+        appendSection(out, emailSlots);
+
+        SnapshotHeader header;
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.recordSize = sizeof(SnapshotRecord);
+        header.rowCount = records.size();
+        header.heapSize = heap.size();
+        header.nameEntryCount = nameEntries.size();
+        header.namePostingCount = namePostings.size();
+        header.emailEntryCount = emailRows.size();
+        header.nameSlotCount = nameSlots.size();
+        header.emailSlotCount = emailSlots.size();
+        header.checksum = snapshotChecksum(out.data() + sizeof(SnapshotHeader), out.size() - sizeof(SnapshotHeader));
+        std::memcpy(out.data(), &header, sizeof(header));
+        return out;
+    }
+
+    // Written next to filename and renamed over it, so a reader that has
+    // the old file mapped keeps seeing the old file. False when the data
+    // does not fit the format (nothing is written then) or on I/O errors.
+    bool write(const std::string& filename) {
+        std::string out = image();
+        if (out.empty()) return false;
+        std::string temporary = filename + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(out.data(), out.size());
+            if (!file) return false;
+        }
+        return std::rename(temporary.c_str(), filename.c_str()) == 0;
+    }
+};
+
+// Maps a snapshot file read-only (or takes an image built in memory) and
+// validates it. Sections are used in place: rows and both hash tables are
+// read straight from the mapping, nothing is parsed or copied until asked for.
+class SnapshotReader {
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+    std::string owned;  // the image, when not mapped from a file
+    bool valid = false;
+    SnapshotHeader header{};
+    const char* heap = nullptr;
+    const SnapshotRecord* records = nullptr;
+    const SnapshotNameEntry* nameEntries = nullptr;
+    const uint32_t* namePostings = nullptr;
+    const uint32_t* emailRows = nullptr;
+    const SnapshotSlot* nameSlots = nullptr;
+    const SnapshotSlot* emailSlots = nullptr;
+
+    SnapshotReader() = default;
+
+    bool validate() {
+        if (size < sizeof(SnapshotHeader)) return false;
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) return false;
+        if (header.version != SNAPSHOT_VERSION || header.recordSize != sizeof(SnapshotRecord)) return false;
+
+        // Counts larger than the file cannot be right and could overflow below
+        for (uint64_t count : {header.heapSize, header.rowCount, header.nameEntryCount, header.namePostingCount,
+                               header.emailEntryCount, header.nameSlotCount, header.emailSlotCount}) {
+            if (count > size) return false;
+        }
+        size_t offset = sizeof(SnapshotHeader);
+        size_t heapOffset = offset;
+        offset += snapshotAlign(header.heapSize);
+        size_t recordsOffset = offset;
+        offset += snapshotAlign(header.rowCount * sizeof(SnapshotRecord));
+        size_t entriesOffset = offset;
+        offset += snapshotAlign(header.nameEntryCount * sizeof(SnapshotNameEntry));
+        size_t postingsOffset = offset;
+        offset += snapshotAlign(header.namePostingCount * sizeof(uint32_t));
+        size_t emailOffset = offset;
+        offset += snapshotAlign(header.emailEntryCount * sizeof(uint32_t));
+        size_t nameSlotsOffset = offset;
+        offset += header.nameSlotCount * sizeof(SnapshotSlot);
+        size_t emailSlotsOffset = offset;
+        offset += header.emailSlotCount * sizeof(SnapshotSlot);
+        if (offset != size) return false;
+
+        const char* payload = data + sizeof(SnapshotHeader);
+        if (snapshotChecksum(payload, size - sizeof(SnapshotHeader)) != header.checksum) return false;
+
+        heap = data + heapOffset;
+        records = reinterpret_cast<const SnapshotRecord*>(data + recordsOffset);
+        nameEntries = reinterpret_cast<const SnapshotNameEntry*>(data + entriesOffset);
+        namePostings = reinterpret_cast<const uint32_t*>(data + postingsOffset);
+        emailRows = reinterpret_cast<const uint32_t*>(data + emailOffset);
+        nameSlots = reinterpret_cast<const SnapshotSlot*>(data + nameSlotsOffset);
+        emailSlots = reinterpret_cast<const SnapshotSlot*>(data + emailSlotsOffset);
+        return referencesInBounds() &&
+               tableInBounds(nameSlots, header.nameSlotCount, header.nameEntryCount, header.nameEntryCount) &&
+               tableInBounds(emailSlots, header.emailSlotCount, header.emailEntryCount, header.rowCount);
+    }
+
+    bool referencesInBounds() const {
+        auto inHeap = [&](const SnapshotString& ref) {
+            return uint64_t(ref.offset) + ref.length <= header.heapSize;
+        };
+        for (size_t i = 0; i < header.rowCount; i++) {
+            const SnapshotRecord& r = records[i];
+            if (!inHeap(r.name) || !inHeap(r.surname) || !inHeap(r.email) ||
+                !inHeap(r.group) || !inHeap(r.phoneNumber)) return false;
+        }
+        for (size_t i = 0; i < header.nameEntryCount; i++) {
+            const SnapshotNameEntry& e = nameEntries[i];
+            if (e.postingCount == 0 || uint64_t(e.postingStart) + e.postingCount > header.namePostingCount) return false;
+        }
+        for (size_t i = 0; i < header.namePostingCount; i++) {
+            if (namePostings[i] >= header.rowCount) return false;
+        }
+        for (size_t i = 0; i < header.emailEntryCount; i++) {
+            if (emailRows[i] >= header.rowCount) return false;
+        }
+        return true;
+    }
+
+    // A table of the size the writer makes for count keys, holding count
+    // ids below limit, so every probe ends at an empty slot in bounds
+    static bool tableInBounds(const SnapshotSlot* slots, size_t slotCount, size_t count, size_t limit) {
+        if (slotCount != snapshotSlotCount(count)) return false;
+        size_t used = 0;
+        for (size_t i = 0; i < slotCount; i++) {
+            if (slots[i].value == 0) continue;
+            if (slots[i].value > limit) return false;
+            used++;
+        }
+        return used == count;
+    }
+
+public:
+    explicit SnapshotReader(const std::string& filename) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return;
+
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* region = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (region != MAP_FAILED) {
+                data = static_cast<const char*>(region);
+                size = st.st_size;
+                mapped = true;
+                valid = validate();
+            }
+        }
+        ::close(fd);
+    }
+
+    // Reader over an image from SnapshotWriter::image, kept in memory
+    static std::unique_ptr<SnapshotReader> fromImage(std::string image) {
+        std::unique_ptr<SnapshotReader> reader(new SnapshotReader());
+        reader->owned = std::move(image);
+        reader->data = reader->owned.data();
+        reader->size = reader->owned.size();
+        reader->valid = reader->validate();
+        return reader;
+    }
+
+    ~SnapshotReader() {
+        if (mapped) {
+            ::munmap(const_cast<char*>(data), size);
+        }
+    }
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    bool isValid() const { return valid; }
+    size_t rowCount() const { return header.rowCount; }
+    size_t nameEntryCount() const { return header.nameEntryCount; }
+    size_t emailEntryCount() const { return header.emailEntryCount; }
+    size_t byteSize() const { return size; }
+    bool isMapped() const { return mapped; }
+
+    std::string_view string(const SnapshotString& ref) const {
+        return std::string_view(heap + ref.offset, ref.length);
+    }
+
+    const SnapshotRecord& record(size_t row) const {
+        return records[row];
+    }
+
+    // Row with its strings pointing into the mapping
+    StudentView view(size_t row) const {
+        const SnapshotRecord& r = records[row];
+        StudentView s;
+        s.m_name = string(r.name);
+        s.m_surname = string(r.surname);
+        s.m_email = string(r.email);
+        s.m_birth_year = r.birthYear;
+        s.m_birth_month = r.birthMonth;
+        s.m_birth_day = r.birthDay;
+        s.m_group = string(r.group);
+        s.m_rating = r.rating;
+        s.m_phone_number = string(r.phoneNumber);
+        return s;
+    }
+
+    Student student(size_t row) const {
+        return view(row).toStudent();
+    }
+
+    std::vector<Student> students() const {
+        std::vector<Student> result;
+        result.reserve(rowCount());
+        for (size_t i = 0; i < rowCount(); i++) {
+            result.push_back(student(i));
+        }
+        return result;
+    }
+
+    // Row ids of name entry i
+    const uint32_t* namePostingsBegin(size_t i) const {
+        return namePostings + nameEntries[i].postingStart;
+    }
+
+    const uint32_t* namePostingsEnd(size_t i) const {
+        return namePostingsBegin(i) + nameEntries[i].postingCount;
+    }
+
+    size_t emailRow(size_t i) const {
+        return emailRows[i];
+    }
+
+    // Name entry of name|surname from the mapped table, or SNAPSHOT_NOT_FOUND
+    size_t findNameEntry(std::string_view name, std::string_view surname) const {
+        const SnapshotSlot& slot = nameSlots[snapshotProbe(nameSlots, header.nameSlotCount,
+            snapshotKeyHash(name, surname), [&](uint32_t entry) {
+                const SnapshotRecord& first = records[*namePostingsBegin(entry)];
+                return string(first.name) == name && string(first.surname) == surname;
+            })];
+        return slot.value == 0 ? SNAPSHOT_NOT_FOUND : slot.value - 1;
+    }
+
+    // Row of email from the mapped table, or SNAPSHOT_NOT_FOUND
+    size_t findEmailRow(std::string_view email) const {
+        const SnapshotSlot& slot = emailSlots[snapshotProbe(emailSlots, header.emailSlotCount,
+            snapshotKeyHash(email), [&](uint32_t row) { return string(records[row].email) == email; })];
+        return slot.value == 0 ? SNAPSHOT_NOT_FOUND : slot.value - 1;
+    }
+};
+
+#endif
@@ -2,87 +2,523 @@
 #define SORTER_H
 
 #include "Student.h"
+#include "Parallel.h"
+#include "CsvWriter.h"
 #include <vector>
 #include <algorithm>
-#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <numeric>
+#include <string_view>
+#include <type_traits>
+
+// Sort keys for Sorter::sortBy, resolved at compile time.
+// SortKey<&Student::m_group> orders by one field: strings byte-wise (like
+// std::string's operator<), integers and floats numerically. Desc<Key>
+// reverses a key; equal values still keep their input order.
+// Any type with a static get(const Student&) returning one of those works too.
+template <auto Member>
+struct SortKey {
+    static const auto& get(const Student& s) { return s.*Member; }
+};
+
+template <typename Key>
+struct Desc {
+    static decltype(auto) get(const Student& s) { return Key::get(s); }
+};
 
 class Sorter {
 public:
-    static void standardSort(std::vector<Student>& students) {
-        std::sort(students.begin(), students.end(), StudentComparator());
+    // std::sort; with threads > 1, a parallel merge sort: each thread
+    // std::sorts one chunk, then pairs of sorted runs are merged with every
+    // thread writing its own slice of the output, so all threads stay busy
+    // in every round. Same (surname, name) order as StudentComparator.
+    static void standardSort(std::vector<Student>& students, size_t threads = 1) {
+        threads = std::min(threads, students.size() / MIN_ROWS_PER_THREAD);
+        if (threads <= 1) {
+            std::sort(students.begin(), students.end(), StudentComparator());
+            return;
+        }
+
+        const size_t n = students.size();
+        std::vector<size_t> bounds(threads + 1);
+        for (size_t t = 0; t <= threads; t++) {
+            bounds[t] = n * t / threads;
+        }
+        parallelFor(threads, [&](size_t t) {
+            std::sort(students.begin() + bounds[t], students.begin() + bounds[t + 1], StudentComparator());
+        });
+
+        // Round by round, thread t writes chunk t of the output. A chunk lies
+        // inside one pair of runs, and every split point is found before any
+        // element is moved out of `from`.
+        std::vector<Student> buffer(n);
+        Student* from = students.data();
+        Student* to = buffer.data();
+        std::vector<size_t> splits(threads);
+        for (size_t width = 1; width < threads; width *= 2) {
+            auto runsOf = [&](size_t t, size_t& lo, size_t& mid, size_t& hi) {
+                size_t first = t - t % (2 * width);
+                lo = bounds[first];
+                mid = bounds[std::min(first + width, threads)];
+                hi = bounds[std::min(first + 2 * width, threads)];
+            };
+            parallelFor(threads, [&](size_t t) {
+                size_t lo, mid, hi;
+                runsOf(t, lo, mid, hi);
+                splits[t] = splitPoint(from + lo, mid - lo, from + mid, hi - mid, bounds[t] - lo);
+            });
+            parallelFor(threads, [&](size_t t) {
+                size_t lo, mid, hi;
+                runsOf(t, lo, mid, hi);
+                bool lastInPair = bounds[t + 1] == hi;
+                size_t i = splits[t];
+                size_t iEnd = lastInPair ? mid - lo : splits[t + 1];
+                mergeRange(from + lo, i, iEnd, from + mid, bounds[t] - lo - i, bounds[t + 1] - lo - iEnd,
+                           to + bounds[t]);
+            });
+            std::swap(from, to);
+        }
+        if (from != students.data()) students.swap(buffer);
+    }
+
+    // MSD radix sort by surname, then name (same order as StudentComparator, stable).
+    // Keys are extracted once as "surname\0name"; only (8-byte key prefix, row)
+    // entries move while sorting, and the Students are permuted once at the end.
+    // With threads > 1 the entries are first split on their top two key bytes
+    // with per-thread histograms, and the buckets go to a work-stealing pool.
+    static void radixSort(std::vector<Student>& students, size_t threads = 1) {
+        if (students.size() <= 1) return;
+        threads = std::max<size_t>(1, std::min(threads, students.size() / MIN_ROWS_PER_THREAD));
+
+        const size_t n = students.size();
+        RadixKeys keys(n, threads, [&](size_t i) {
+            return std::array<std::string_view, 2>{students[i].m_surname, students[i].m_name};
+        });
+        std::vector<RadixEntry> entries(n);
+        std::vector<RadixEntry> scratch(n);
+        parallelFor(threads, [&](size_t t) {
+            for (size_t i = n * t / threads; i < n * (t + 1) / threads; i++) {
+                entries[i] = {keys.prefix(i, 0), keys.prefix(i, 8), static_cast<uint32_t>(i), static_cast<uint32_t>(keys.length(i))};
+            }
+        });
+
+        const RadixEntry* order = entries.data();
+        if (threads == 1) {
+            radixSortEntries(keys, entries.data(), scratch.data(), n, 0);
+        } else {
+            splitByTopBytes(keys, entries, scratch, threads);
+            order = scratch.data();
+        }
+
+        // Rows are read in random order, so fetch a few ahead
+        const size_t PREFETCH_DISTANCE = 8;
+        std::vector<Student> sorted(n);
+        parallelFor(threads, [&](size_t t) {
+            size_t end = n * (t + 1) / threads;
+            for (size_t i = n * t / threads; i < end; i++) {
+                if (i + PREFETCH_DISTANCE < end) {
+                    const char* next = reinterpret_cast<const char*>(&students[order[i + PREFETCH_DISTANCE].row]);
+                    for (size_t line = 0; line < sizeof(Student); line += 64) {
+                        __builtin_prefetch(next + line);
+                    }
+                }
+                sorted[i] = std::move(students[order[i].row]);
+            }
+        });
+        students.swap(sorted);
     }
 
-    // MSD radix sort for strings
-    static void radixSort(std::vector<Student>& students) {
-        if (students.empty()) return;
-        radixSortHelper(students, 0, students.size(), 0);
+    // Stable sort by several keys, most significant first, e.g.
+    // sortBy<SortKey<&Student::m_group>, Desc<SortKey<&Student::m_rating>>>(students).
+    // Sorts a row order one key at a time, least significant key first:
+    // numeric keys with an LSD radix over order-preserving 32-bit codes,
+    // string keys with the MSD radix of radixSort. The Students move once.
+    template <typename... Keys>
+    static void sortBy(std::vector<Student>& students) {
+        static_assert(sizeof...(Keys) > 0, "sortBy needs at least one key");
+        if (students.size() <= 1) return;
+
+        std::vector<uint32_t> order(students.size());
+        std::iota(order.begin(), order.end(), 0);
+        sortByKeys<Keys...>(students, order);
+
+        std::vector<Student> sorted;
+        sorted.reserve(students.size());
+        for (uint32_t row : order) {
+            sorted.push_back(std::move(students[row]));
+        }
+        students.swap(sorted);
     }
 
-    static void saveToCSV(const std::vector<Student>& students, const std::string& filename) {
-        std::ofstream file(filename);
+    static bool saveToCSV(const std::vector<Student>& students, const std::string& filename) {
+        CsvWriter writer(filename);
         for (const auto& s : students) {
-            file << s.toCSV() << "\n";
+            writer.writeStudent(s);
         }
+        return writer.close();
     }
 
 private:
-    static int getChar(const Student& s, size_t pos) {
-        std::string combined = s.m_surname + "|" + s.m_name;
-        if (pos >= combined.size()) return -1;
-        return static_cast<unsigned char>(combined[pos]);
+    template <typename Key>
+    struct KeyTraits {
+        using Base = Key;
+        static constexpr bool descending = false;
+    };
+
+    template <typename Key>
+    struct KeyTraits<Desc<Key>> {
+        using Base = typename KeyTraits<Key>::Base;
+        static constexpr bool descending = !KeyTraits<Key>::descending;
+    };
+
+    template <typename Key, typename... Rest>
+    static void sortByKeys(const std::vector<Student>& students, std::vector<uint32_t>& order) {
+        if constexpr (sizeof...(Rest) > 0) {
+            sortByKeys<Rest...>(students, order);
+        }
+        sortByKey<Key>(students, order);
+    }
+
+    // Stable pass that reorders `order` by one key
+    template <typename Key>
+    static void sortByKey(const std::vector<Student>& students, std::vector<uint32_t>& order) {
+        using Base = typename KeyTraits<Key>::Base;
+        using Value = std::decay_t<decltype(Base::get(students[0]))>;
+        constexpr bool descending = KeyTraits<Key>::descending;
+        const size_t n = order.size();
+        std::vector<uint32_t> reordered(n);
+
+        if constexpr (std::is_convertible_v<const Value&, std::string_view>) {
+            // Key i belongs to order[i], so ties on the entry row keep the current order
+            RadixKeys keys(n, 1, [&](size_t i) {
+                return std::array<std::string_view, 1>{std::string_view(Base::get(students[order[i]]))};
+            });
+            std::vector<RadixEntry> entries(n);
+            std::vector<RadixEntry> scratch(n);
+            for (size_t i = 0; i < n; i++) {
+                entries[i] = {keys.prefix(i, 0), keys.prefix(i, 8), static_cast<uint32_t>(i), static_cast<uint32_t>(keys.length(i))};
+            }
+            radixSortEntries(keys, entries.data(), scratch.data(), n, 0);
+
+            if (descending) {
+                // Reversing flips equal keys too, so flip each run of them back
+                std::reverse(entries.begin(), entries.end());
+                for (size_t begin = 0, end; begin < n; begin = end) {
+                    for (end = begin + 1; end < n && keys.equal(entries[end].row, entries[begin].row); end++) {}
+                    std::reverse(entries.begin() + begin, entries.begin() + end);
+                }
+            }
+            for (size_t i = 0; i < n; i++) {
+                reordered[i] = order[entries[i].row];
+            }
+        } else {
+            static_assert(std::is_arithmetic_v<Value> && sizeof(Value) <= 4,
+                          "sortBy keys must be strings or numbers of up to 32 bits");
+            std::vector<NumericEntry> entries(n);
+            std::vector<NumericEntry> scratch(n);
+            for (size_t i = 0; i < n; i++) {
+                uint32_t code = numericCode(Base::get(students[order[i]]));
+                entries[i] = {descending ? ~code : code, order[i]};
+            }
+            sortByCode(entries.data(), scratch.data(), n);
+            for (size_t i = 0; i < n; i++) {
+                reordered[i] = entries[i].row;
+            }
+        }
+        order.swap(reordered);
+    }
+
+    struct NumericEntry {
+        uint32_t code;
+        uint32_t row;
+    };
+
+    // Maps a number to a code whose unsigned order is the number's order
+    template <typename Value>
+    static uint32_t numericCode(Value value) {
+        if constexpr (std::is_floating_point_v<Value>) {
+            float f = value == 0 ? 0.0f : static_cast<float>(value);  // -0 sorts with +0
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            // Negative floats order backwards in their bits, so flip them whole;
+            // setting the sign bit puts every positive one above them
+            return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+        } else if constexpr (std::is_signed_v<Value>) {
+            return static_cast<uint32_t>(static_cast<int32_t>(value)) ^ 0x80000000u;
+        } else {
+            return static_cast<uint32_t>(value);
+        }
     }
 
-    static void radixSortHelper(std::vector<Student>& students, size_t start, size_t end, size_t charPos) {
-        if (end - start <= 1) return;
-        
-        // Use insertion sort for small subarrays
-        if (end - start < 10) {
-            for (size_t i = start + 1; i < end; i++) {
-                Student key = students[i];
+    // Stable LSD passes over the 4 code bytes, skipping bytes that are the same in every entry
+    static void sortByCode(NumericEntry* entries, NumericEntry* scratch, size_t n) {
+        uint32_t counts[4][256] = {};
+        for (size_t i = 0; i < n; i++) {
+            for (size_t b = 0; b < 4; b++) {
+                counts[b][(entries[i].code >> (8 * b)) & 0xFF]++;
+            }
+        }
+
+        NumericEntry* from = entries;
+        NumericEntry* to = scratch;
+        for (size_t b = 0; b < 4; b++) {
+            uint32_t* count = counts[b];
+            if (count[(from[0].code >> (8 * b)) & 0xFF] == n) continue;
+
+            uint32_t offset = 0;
+            for (size_t c = 0; c < 256; c++) {
+                uint32_t size = count[c];
+                count[c] = offset;
+                offset += size;
+            }
+            for (size_t i = 0; i < n; i++) {
+                to[count[(from[i].code >> (8 * b)) & 0xFF]++] = from[i];
+            }
+            std::swap(from, to);
+        }
+        if (from != entries) {
+            std::copy(from, from + n, entries);
+        }
+    }
+
+    // Below this many rows per thread, starting threads costs more than it saves
+    static constexpr size_t MIN_ROWS_PER_THREAD = 8192;
+
+    // Stable merge of a[i, iEnd) and b[j, jEnd), moved to out; ties take a first
+    static void mergeRange(Student* a, size_t i, size_t iEnd, Student* b, size_t j, size_t jEnd, Student* out) {
+        StudentComparator less;
+        while (i < iEnd && j < jEnd) {
+            *out++ = less(b[j], a[i]) ? std::move(b[j++]) : std::move(a[i++]);
+        }
+        out = std::move(a + i, a + iEnd, out);
+        std::move(b + j, b + jEnd, out);
+    }
+
+    // How many of the first k merged elements come from a
+    static size_t splitPoint(const Student* a, size_t na, const Student* b, size_t nb, size_t k) {
+        size_t lo = k > nb ? k - nb : 0;
+        size_t hi = std::min(k, na);
+        StudentComparator less;
+        while (lo < hi) {
+            size_t i = lo + (hi - lo) / 2;
+            // a[i] is among the first k if it does not sort after b[k - i - 1]
+            if (!less(b[k - i - 1], a[i])) {
+                lo = i + 1;
+            } else {
+                hi = i;
+            }
+        }
+        return lo;
+    }
+
+    struct RadixEntry {
+        uint64_t prefix;    // key bytes [depth, depth + 8), big endian, zero padded
+        uint64_t next;      // key bytes [depth + 8, depth + 16), so going one level deeper
+                            // does not have to reach into the key buffer at random
+        uint32_t row;
+        uint32_t length;
+    };
+
+    // Every row's sort key, packed into one buffer
+    class RadixKeys {
+    private:
+        std::vector<char> bytes;
+        std::vector<size_t> offsets;
+
+    public:
+        // partsOf(i) gives key i as an array of string_views, joined with '\0'
+        template <typename PartsFn>
+        RadixKeys(size_t n, size_t threads, PartsFn partsOf) {
+            offsets.resize(n + 1);
+            offsets[0] = 0;
+            for (size_t i = 0; i < n; i++) {
+                size_t size = 0;
+                for (std::string_view part : partsOf(i)) {
+                    size += part.size() + 1;
+                }
+                offsets[i + 1] = offsets[i] + size - 1;
+            }
+            bytes.resize(offsets[n]);
+            parallelFor(threads, [&](size_t t) {
+                for (size_t i = n * t / threads; i < n * (t + 1) / threads; i++) {
+                    char* key = bytes.data() + offsets[i];
+                    bool first = true;
+                    for (std::string_view part : partsOf(i)) {
+                        if (!first) *key++ = '\0';
+                        std::memcpy(key, part.data(), part.size());
+                        key += part.size();
+                        first = false;
+                    }
+                }
+            });
+        }
+
+        size_t length(size_t row) const {
+            return offsets[row + 1] - offsets[row];
+        }
+
+        uint64_t prefix(size_t row, size_t depth) const {
+            uint64_t value = 0;
+            size_t len = length(row);
+            const char* key = bytes.data() + offsets[row];
+            for (size_t i = 0; i < 8; i++) {
+                unsigned char c = depth + i < len ? static_cast<unsigned char>(key[depth + i]) : 0;
+                value = (value << 8) | c;
+            }
+            return value;
+        }
+
+        bool equal(uint32_t a, uint32_t b) const {
+            return length(a) == length(b) && std::memcmp(bytes.data() + offsets[a], bytes.data() + offsets[b], length(a)) == 0;
+        }
+
+        // Compares the keys from byte `depth` on, then by row for stability
+        bool less(uint32_t a, uint32_t b, size_t depth) const {
+            size_t lenA = length(a), lenB = length(b);
+            size_t restA = lenA > depth ? lenA - depth : 0;
+            size_t restB = lenB > depth ? lenB - depth : 0;
+            int cmp = std::memcmp(bytes.data() + offsets[a] + depth, bytes.data() + offsets[b] + depth,
+                                  std::min(restA, restB));
+            if (cmp != 0) return cmp < 0;
+            if (restA != restB) return restA < restB;
+            return a < b;
+        }
+    };
+
+    static constexpr size_t INSERTION_SORT_THRESHOLD = 16;
+    // Below this, comparing whole prefixes beats clearing and scanning 8 histograms
+    static constexpr size_t COMPARISON_SORT_THRESHOLD = 256;
+
+    // Equal prefixes only need a deeper pass while some key goes on past them
+    static bool anyLongerThan(const RadixEntry* entries, size_t n, size_t length) {
+        for (size_t i = 0; i < n; i++) {
+            if (entries[i].length > length) return true;
+        }
+        return false;
+    }
+
+    // Sorts entries[0, n) whose keys share their first `depth` bytes: orders
+    // them by the 8-byte prefix, then each run of equal prefixes whose keys go
+    // on recurses 8 bytes deeper. Ties keep row order, so the sort is stable.
+    static void radixSortEntries(const RadixKeys& keys, RadixEntry* entries, RadixEntry* scratch,
+                                 size_t n, size_t depth) {
+        if (n < INSERTION_SORT_THRESHOLD) {
+            for (size_t i = 1; i < n; i++) {
+                RadixEntry e = entries[i];
                 size_t j = i;
-                while (j > start && StudentComparator()(key, students[j - 1])) {
-                    students[j] = students[j - 1];
+                while (j > 0 && keys.less(e.row, entries[j - 1].row, depth)) {
+                    entries[j] = entries[j - 1];
                     j--;
                 }
-                students[j] = key;
+                entries[j] = e;
             }
             return;
         }
 
-        // Count characters (256 possible bytes + 1 for end-of-string)
-        const int R = 257;
-        std::vector<int> count(R + 1, 0);
-        
-        // Count frequencies
-        for (size_t i = start; i < end; i++) {
-            int c = getChar(students[i], charPos);
-            count[c + 2]++;
-        }
-        
-        // Compute cumulative counts
-        for (int r = 0; r < R; r++) {
-            count[r + 1] += count[r];
-        }
-        
-        // Distribute
-        std::vector<Student> aux(end - start);
-        for (size_t i = start; i < end; i++) {
-            int c = getChar(students[i], charPos);
-            aux[count[c + 1]++] = students[i];
-        }
-        
-        // Copy back
-        for (size_t i = 0; i < aux.size(); i++) {
-            students[start + i] = aux[i];
-        }
-        
-        // Recursively sort each character group
-        for (int r = 0; r < R; r++) {
-            size_t subStart = start + count[r];
-            size_t subEnd = start + count[r + 1];
-            if (subEnd - subStart > 0 && r >= 0) {
-                radixSortHelper(students, subStart, subEnd, charPos + 1);
+        if (n < COMPARISON_SORT_THRESHOLD) {
+            std::sort(entries, entries + n, [](const RadixEntry& a, const RadixEntry& b) {
+                return a.prefix != b.prefix ? a.prefix < b.prefix : a.row < b.row;
+            });
+        } else {
+            sortByPrefix(entries, scratch, n);
+        }
+
+        for (size_t begin = 0, end; begin < n; begin = end) {
+            for (end = begin + 1; end < n && entries[end].prefix == entries[begin].prefix; end++) {}
+            if (end - begin > 1 && anyLongerThan(entries + begin, end - begin, depth + 8)) {
+                for (size_t i = begin; i < end; i++) {
+                    RadixEntry& e = entries[i];
+                    e.prefix = e.next;
+                    e.next = e.length > depth + 16 ? keys.prefix(e.row, depth + 16) : 0;
+                }
+                radixSortEntries(keys, entries + begin, scratch + begin, end - begin, depth + 8);
+            }
+        }
+    }
+
+    // Parallel first level of radixSort: scatters `entries` into `scratch` by
+    // the top 16 prefix bits (threads take contiguous chunks in order, so the
+    // scatter is stable), then sorts every bucket in place in `scratch`,
+    // largest first, on a work-stealing pool. UTF-8 Cyrillic shares its
+    // first byte, so one byte alone would leave only two buckets.
+    static void splitByTopBytes(const RadixKeys& keys, std::vector<RadixEntry>& entries,
+                                std::vector<RadixEntry>& scratch, size_t threads) {
+        static constexpr size_t BUCKETS = 1 << 16;
+        const size_t n = entries.size();
+        auto bucketOf = [](const RadixEntry& e) { return static_cast<size_t>(e.prefix >> 48); };
+
+        std::vector<std::vector<uint32_t>> counts(threads, std::vector<uint32_t>(BUCKETS));
+        parallelFor(threads, [&](size_t t) {
+            for (size_t i = n * t / threads; i < n * (t + 1) / threads; i++) {
+                counts[t][bucketOf(entries[i])]++;
+            }
+        });
+
+        std::vector<size_t> bucketStart(BUCKETS + 1);
+        size_t offset = 0;
+        for (size_t b = 0; b < BUCKETS; b++) {
+            bucketStart[b] = offset;
+            for (size_t t = 0; t < threads; t++) {
+                uint32_t size = counts[t][b];
+                counts[t][b] = static_cast<uint32_t>(offset);
+                offset += size;
+            }
+        }
+        bucketStart[BUCKETS] = offset;
+
+        parallelFor(threads, [&](size_t t) {
+            for (size_t i = n * t / threads; i < n * (t + 1) / threads; i++) {
+                scratch[counts[t][bucketOf(entries[i])]++] = entries[i];
             }
+        });
+
+        std::vector<size_t> buckets;
+        for (size_t b = 0; b < BUCKETS; b++) {
+            if (bucketStart[b + 1] - bucketStart[b] > 1) buckets.push_back(b);
+        }
+        std::sort(buckets.begin(), buckets.end(), [&](size_t a, size_t b) {
+            return bucketStart[a + 1] - bucketStart[a] > bucketStart[b + 1] - bucketStart[b];
+        });
+
+        // Each bucket uses the matching range of `entries` as its scratch
+        parallelForEachTask(buckets.size(), threads, [&](size_t task) {
+            size_t begin = bucketStart[buckets[task]];
+            size_t end = bucketStart[buckets[task] + 1];
+            radixSortEntries(keys, scratch.data() + begin, entries.data() + begin, end - begin, 0);
+        });
+    }
+
+    // Stable LSD passes over the 8 prefix bytes, skipping bytes that are the same in every entry
+    static void sortByPrefix(RadixEntry* entries, RadixEntry* scratch, size_t n) {
+        uint32_t counts[8][256] = {};
+        for (size_t i = 0; i < n; i++) {
+            uint64_t prefix = entries[i].prefix;
+            for (size_t b = 0; b < 8; b++) {
+                counts[b][(prefix >> (8 * b)) & 0xFF]++;
+            }
+        }
+
+        RadixEntry* from = entries;
+        RadixEntry* to = scratch;
+        for (size_t b = 0; b < 8; b++) {
+            uint32_t* count = counts[b];
+            if (count[(from[0].prefix >> (8 * b)) & 0xFF] == n) continue;
+
+            uint32_t offset = 0;
+            for (size_t c = 0; c < 256; c++) {
+                uint32_t size = count[c];
+                count[c] = offset;
+                offset += size;
+            }
+            for (size_t i = 0; i < n; i++) {
+                to[count[(from[i].prefix >> (8 * b)) & 0xFF]++] = from[i];
+            }
+            std::swap(from, to);
+        }
+        if (from != entries) {
+            std::copy(from, from + n, entries);
         }
     }
 };
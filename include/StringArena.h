@@ -0,0 +1,74 @@
+#ifndef STRING_ARENA_H
+#define STRING_ARENA_H
+
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <algorithm>
+
+// Bump allocator for string bytes.
+// Bytes are copied into large chunks that never move, so the returned
+// string_views stay valid until clear(), which frees everything at once.
+class StringArena {
+private:
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> chunks;
+    std::vector<size_t> chunkSizes;
+    char* cursor = nullptr;
+    size_t remaining = 0;
+
+    char* allocate(size_t size) {
+        if (size > remaining) {
+            size_t chunkSize = std::max(CHUNK_SIZE, size);
+            chunks.emplace_back(new char[chunkSize]);
+            chunkSizes.push_back(chunkSize);
+            cursor = chunks.back().get();
+            remaining = chunkSize;
+        }
+        char* result = cursor;
+        cursor += size;
+        remaining -= size;
+        return result;
+    }
+
+public:
+    StringArena() = default;
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    std::string_view store(std::string_view value) {
+        if (value.empty()) return std::string_view();
+        char* bytes = allocate(value.size());
+        std::memcpy(bytes, value.data(), value.size());
+        return std::string_view(bytes, value.size());
+    }
+
+    // Stores first + separator + second as one string
+    std::string_view storeJoined(std::string_view first, char separator, std::string_view second) {
+        size_t size = first.size() + 1 + second.size();
+        char* bytes = allocate(size);
+        std::memcpy(bytes, first.data(), first.size());
+        bytes[first.size()] = separator;
+        std::memcpy(bytes + first.size() + 1, second.data(), second.size());
+        return std::string_view(bytes, size);
+    }
+
+    void clear() {
+        chunks.clear();
+        chunkSizes.clear();
+        cursor = nullptr;
+        remaining = 0;
+    }
+
+    size_t getMemoryUsage() const {
+        size_t size = chunks.capacity() * sizeof(std::unique_ptr<char[]>) + chunkSizes.capacity() * sizeof(size_t);
+        for (size_t chunkSize : chunkSizes) {
+            size += chunkSize;
+        }
+        return size;
+    }
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef STRING_DICTIONARY_H
+#define STRING_DICTIONARY_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <algorithm>
+
+// Interns strings into dense 32-bit ids.
+// All bytes live in one buffer; lookup goes through an open addressing table
+// of ids (linear probing, load factor <= 0.5), so there is no node per string.
+class StringDictionary {
+private:
+    std::string bytes;
+    std::vector<uint32_t> offsets{0}; // id i -> bytes[offsets[i], offsets[i + 1])
+    std::vector<uint32_t> slots;      // 0 = empty, otherwise id + 1
+
+    static size_t hashOf(std::string_view value) {
+        return std::hash<std::string_view>()(value);
+    }
+
+    void grow() {
+        std::vector<uint32_t> newSlots(std::max<size_t>(16, slots.size() * 2), 0);
+        size_t mask = newSlots.size() - 1;
+        for (uint32_t id = 0; id < size(); id++) {
+            size_t i = hashOf(get(id)) & mask;
+            while (newSlots[i] != 0) i = (i + 1) & mask;
+            newSlots[i] = id + 1;
+        }
+        slots.swap(newSlots);
+    }
+
+    // Slot holding value, or the empty slot where it would go
+    size_t probe(std::string_view value) const {
+        size_t mask = slots.size() - 1;
+        size_t i = hashOf(value) & mask;
+        while (slots[i] != 0 && get(slots[i] - 1) != value) {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+public:
+    size_t size() const {
+        return offsets.size() - 1;
+    }
+
+    std::string_view get(uint32_t id) const {
+        return std::string_view(bytes.data() + offsets[id], offsets[id + 1] - offsets[id]);
+    }
+
+    bool find(std::string_view value, uint32_t& id) const {
+        if (slots.empty()) return false;
+        size_t i = probe(value);
+        if (slots[i] == 0) return false;
+        id = slots[i] - 1;
+        return true;
+    }
+
+    uint32_t intern(std::string_view value) {
+        if ((size() + 1) * 2 > slots.size()) grow();
+        size_t i = probe(value);
+        if (slots[i] != 0) return slots[i] - 1;
+
+        uint32_t id = static_cast<uint32_t>(size());
+        bytes.append(value);
+        offsets.push_back(static_cast<uint32_t>(bytes.size()));
+        slots[i] = id + 1;
+        return id;
+    }
+
+    void clear() {
+        bytes.clear();
+        offsets.assign(1, 0);
+        slots.clear();
+    }
+
+    size_t getMemoryUsage() const {
+        return bytes.capacity() + offsets.capacity() * sizeof(uint32_t) + slots.capacity() * sizeof(uint32_t);
+    }
+};
+
+#endif
@@ -2,8 +2,11 @@
 #define STUDENT_H
 
 #include <string>
-#include <sstream>
+#include <string_view>
 #include <vector>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
 
 struct Student {
     std::string m_name;
@@ -16,47 +19,145 @@ struct Student {
     float m_rating;
     std::string m_phone_number;
 
-    static Student fromCSV(const std::string& line) {
-        Student s;
-        std::stringstream ss(line);
-        std::string field;
-        
-        std::getline(ss, s.m_name, ',');
-        std::getline(ss, s.m_surname, ',');
-        std::getline(ss, s.m_email, ',');
-        
-        std::getline(ss, field, ',');
-        s.m_birth_year = std::stoi(field);
-        
-        std::getline(ss, field, ',');
-        s.m_birth_month = std::stoi(field);
-        
-        std::getline(ss, field, ',');
-        s.m_birth_day = std::stoi(field);
-        
-        std::getline(ss, s.m_group, ',');
-        
-        std::getline(ss, field, ',');
-        s.m_rating = std::stof(field);
+    static Student fromCSV(std::string_view line);
+
+    std::string toCSV() const;
+};
+
+// Student whose string fields point into storage owned by someone else
+// (a CSV line, an arena, a Student). Valid only while that storage lives.
+struct StudentView {
+    std::string_view m_name;
+    std::string_view m_surname;
+    std::string_view m_email;
+    int m_birth_year = 0;
+    int m_birth_month = 0;
+    int m_birth_day = 0;
+    std::string_view m_group;
+    float m_rating = 0.0f;
+    std::string_view m_phone_number;
+
+    StudentView() = default;
+
+    StudentView(const Student& s)
+        : m_name(s.m_name), m_surname(s.m_surname), m_email(s.m_email),
+          m_birth_year(s.m_birth_year), m_birth_month(s.m_birth_month), m_birth_day(s.m_birth_day),
+          m_group(s.m_group), m_rating(s.m_rating), m_phone_number(s.m_phone_number) {}
+
+    // Parses one CSV row in place: fields are located with memchr and
+    // numbers converted with from_chars, no intermediate stream or line copy
+    static StudentView fromCSV(std::string_view line) {
+        StudentView s;
+        std::string_view rest = line;
+
+        s.m_name = nextField(rest);
+        s.m_surname = nextField(rest);
+        s.m_email = nextField(rest);
+        s.m_birth_year = parseNumber<int>(nextField(rest));
+        s.m_birth_month = parseNumber<int>(nextField(rest));
+        s.m_birth_day = parseNumber<int>(nextField(rest));
+        s.m_group = nextField(rest);
+        s.m_rating = parseNumber<float>(nextField(rest));
 
         // Handle case where last field dont have trailing comma
-        if (std::getline(ss, s.m_phone_number, ',') || std::getline(ss, s.m_phone_number)) {
-            // Remove any trailing whitespace or newline
-            s.m_phone_number.erase(s.m_phone_number.find_last_not_of(" \n\r\t") + 1);
-        }
-        
+        std::string_view phone = nextField(rest);
+        // Remove any trailing whitespace or newline
+        size_t last = phone.find_last_not_of(" \n\r\t");
+        s.m_phone_number = phone.substr(0, last == std::string_view::npos ? 0 : last + 1);
+
         return s;
     }
 
-    std::string toCSV() const {
-        std::stringstream ss;
-        ss << m_name << "," << m_surname << "," << m_email << ","
-           << m_birth_year << "," << m_birth_month << "," << m_birth_day << ","
-           << m_group << "," << m_rating << "," << m_phone_number;
-        return ss.str();
+    // Upper bound on the bytes formatCSV writes
+    size_t csvSizeBound() const {
+        // 8 commas, 3 ints of up to 11 chars, a float of up to 15
+        return m_name.size() + m_surname.size() + m_email.size() + m_group.size() + m_phone_number.size() +
+               8 + 3 * 11 + 15;
+    }
+
+    // Writes the row as one CSV line (no newline) to out, which has room for
+    // csvSizeBound() bytes, and returns the end. Numbers go through
+    // std::to_chars; the rating is the shortest text that parses back to
+    // the same float.
+    char* formatCSV(char* out) const {
+        out = appendField(out, m_name);
+        out = appendField(out, m_surname);
+        out = appendField(out, m_email);
+        out = std::to_chars(out, out + 11, m_birth_year).ptr;
+        *out++ = ',';
+        out = std::to_chars(out, out + 11, m_birth_month).ptr;
+        *out++ = ',';
+        out = std::to_chars(out, out + 11, m_birth_day).ptr;
+        *out++ = ',';
+        out = appendField(out, m_group);
+        out = std::to_chars(out, out + 15, m_rating).ptr;
+        *out++ = ',';
+        std::memcpy(out, m_phone_number.data(), m_phone_number.size());
+        return out + m_phone_number.size();
+    }
+
+    Student toStudent() const {
+        Student s;
+        s.m_name = m_name;
+        s.m_surname = m_surname;
+        s.m_email = m_email;
+        s.m_birth_year = m_birth_year;
+        s.m_birth_month = m_birth_month;
+        s.m_birth_day = m_birth_day;
+        s.m_group = m_group;
+        s.m_rating = m_rating;
+        s.m_phone_number = m_phone_number;
+        return s;
+    }
+
+private:
+    static char* appendField(char* out, std::string_view field) {
+        std::memcpy(out, field.data(), field.size());
+        out += field.size();
+        *out++ = ',';
+        return out;
+    }
+
+    // Cuts the next comma separated field off the front of rest
+    static std::string_view nextField(std::string_view& rest) {
+        const char* begin = rest.data();
+        const char* comma = static_cast<const char*>(std::memchr(begin, ',', rest.size()));
+        if (!comma) {
+            std::string_view field = rest;
+            rest = std::string_view();
+            return field;
+        }
+        std::string_view field(begin, comma - begin);
+        rest.remove_prefix(field.size() + 1);
+        return field;
+    }
+
+    template <typename T>
+    static T parseNumber(std::string_view field) {
+        // Same leniency as std::stoi/std::stof for leading blanks and '+'
+        while (!field.empty() && (field.front() == ' ' || field.front() == '\t')) field.remove_prefix(1);
+        if (!field.empty() && field.front() == '+') field.remove_prefix(1);
+
+        T value{};
+        auto [ptr, ec] = std::from_chars(field.data(), field.data() + field.size(), value);
+        if (ec != std::errc()) {
+            throw std::invalid_argument("Invalid number in CSV: " + std::string(field));
+        }
+        return value;
     }
 };
 
+inline Student Student::fromCSV(std::string_view line) {
+    return StudentView::fromCSV(line).toStudent();
+}
+
+inline std::string Student::toCSV() const {
+    StudentView view(*this);
+    std::string line(view.csvSizeBound(), '\0');
+    line.resize(view.formatCSV(line.data()) - line.data());
+    return line;
+}
+
 // Comparator for sorting by (surname, name)
 struct StudentComparator {
     bool operator()(const Student& a, const Student& b) const {
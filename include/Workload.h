@@ -0,0 +1,266 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include "Snapshot.h"
+#include <string>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+// Operation mix, key skew and seed of a benchmark workload.
+// Skews are Zipf exponents: 0 draws keys uniformly, 1 makes the k-th
+// hottest key about k times less likely than the hottest one.
+struct WorkloadConfig {
+    uint64_t seed = 0;
+    int findWeight = 5;     // Operation 1: find by name and surname
+    int groupsWeight = 5;   // Operation 2: groups with duplicate names
+    int updateWeight = 50;  // Operation 3: update group by email
+    double nameSkew = 0.0;  // applies to names and surnames alike
+    double emailSkew = 0.0;
+};
+
+// One operation of a trace: type 0, 1 or 2 (operation 1, 2 or 3) and two
+// indices into WorkloadTrace::strings, (name, surname) for type 0 and
+// (email, new group) for type 2
+struct TraceOperation {
+    uint8_t type;
+    uint32_t first;
+    uint32_t second;
+};
+
+// Random draws built only on the engine's raw output: the std::
+// distributions differ between standard libraries, these give the same
+// trace from the same seed everywhere
+class WorkloadRandom {
+private:
+    std::mt19937_64 engine;
+
+public:
+    explicit WorkloadRandom(uint64_t seed) : engine(seed) {}
+
+    // Uniform in [0, 1)
+    double unit() {
+        return (engine() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // Uniform in [0, n)
+    uint64_t below(uint64_t n) {
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(engine()) * n) >> 64);
+    }
+};
+
+// Zipf distribution over n keys. Rank r (0 = hottest) is drawn with
+// probability proportional to 1 / (r + 1)^exponent from a precomputed CDF,
+// then mapped to a key through a seeded shuffle, so the hot keys are spread
+// over the table instead of being its first entries.
+class ZipfDistribution {
+private:
+    std::vector<double> cdf;     // empty when uniform
+    std::vector<uint32_t> keys;  // rank -> key
+    size_t n;
+
+public:
+    ZipfDistribution(size_t n, double exponent, WorkloadRandom& random) : n(n) {
+        if (exponent <= 0.0 || n == 0) return;
+
+        cdf.resize(n);
+        double sum = 0.0;
+        for (size_t r = 0; r < n; r++) {
+            sum += 1.0 / std::pow(static_cast<double>(r + 1), exponent);
+            cdf[r] = sum;
+        }
+        for (double& c : cdf) {
+            c /= sum;
+        }
+
+        keys.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            keys[i] = static_cast<uint32_t>(i);
+        }
+        for (size_t i = n; i > 1; i--) {
+            std::swap(keys[i - 1], keys[random.below(i)]);
+        }
+    }
+
+    uint32_t operator()(WorkloadRandom& random) const {
+        if (cdf.empty()) return static_cast<uint32_t>(random.below(n));
+        size_t rank = std::upper_bound(cdf.begin(), cdf.end(), random.unit()) - cdf.begin();
+        return keys[std::min(rank, n - 1)];
+    }
+};
+
+const char TRACE_MAGIC[8] = {'S', 'T', 'D', 'B', 'T', 'R', 'C', 'E'};
+const uint32_t TRACE_VERSION = 1;
+
+struct TraceHeader {
+    char magic[8];
+    uint32_t version;
+    int32_t findWeight;
+    int32_t groupsWeight;
+    int32_t updateWeight;
+    uint64_t seed;
+    double nameSkew;
+    double emailSkew;
+    uint64_t datasetSize;
+    uint64_t stringCount;
+    uint64_t stringBytes;
+    uint64_t operationCount;
+    uint64_t checksum;
+};
+
+// A generated sequence of operations plus every string it refers to, so a
+// saved trace replays the same requests against any variant and any build.
+//
+// File layout (native endianness): TraceHeader, uint32_t length per string,
+// the string bytes, then one packed TraceOperation per operation. The
+// checksum covers everything after the header.
+class WorkloadTrace {
+private:
+    struct PackedOperation {
+        uint32_t type;
+        uint32_t first;
+        uint32_t second;
+    };
+
+public:
+    WorkloadConfig config;
+    size_t datasetSize = 0;
+    std::vector<std::string> strings;
+    std::vector<TraceOperation> operations;
+
+    // `length` operations over the dataset's first datasetSize rows: names,
+    // surnames and groups come from the given tables, emails from the first
+    // datasetSize entries of `emails` (those of the loaded rows)
+    static WorkloadTrace generate(const WorkloadConfig& config, size_t length, size_t datasetSize,
+                                  const std::vector<std::string>& names, const std::vector<std::string>& surnames,
+                                  const std::vector<std::string>& emails, const std::vector<std::string>& groups) {
+        WorkloadTrace trace;
+        trace.config = config;
+        trace.datasetSize = datasetSize;
+
+        size_t emailCount = std::min(datasetSize, emails.size());
+        trace.strings.reserve(names.size() + surnames.size() + emailCount + groups.size());
+        uint32_t nameBase = static_cast<uint32_t>(trace.strings.size());
+        trace.strings.insert(trace.strings.end(), names.begin(), names.end());
+        uint32_t surnameBase = static_cast<uint32_t>(trace.strings.size());
+        trace.strings.insert(trace.strings.end(), surnames.begin(), surnames.end());
+        uint32_t emailBase = static_cast<uint32_t>(trace.strings.size());
+        trace.strings.insert(trace.strings.end(), emails.begin(), emails.begin() + emailCount);
+        uint32_t groupBase = static_cast<uint32_t>(trace.strings.size());
+        trace.strings.insert(trace.strings.end(), groups.begin(), groups.end());
+
+        WorkloadRandom random(config.seed);
+        ZipfDistribution nameDist(names.size(), config.nameSkew, random);
+        ZipfDistribution surnameDist(surnames.size(), config.nameSkew, random);
+        ZipfDistribution emailDist(emailCount, config.emailSkew, random);
+        ZipfDistribution groupDist(groups.size(), 0.0, random);
+
+        uint64_t totalWeight = config.findWeight + config.groupsWeight + config.updateWeight;
+        trace.operations.resize(length);
+        for (auto& op : trace.operations) {
+            uint64_t pick = random.below(totalWeight);
+            if (pick < static_cast<uint64_t>(config.findWeight)) {
+                op = {0, nameBase + nameDist(random), surnameBase + surnameDist(random)};
+            } else if (pick < static_cast<uint64_t>(config.findWeight + config.groupsWeight)) {
+                op = {1, 0, 0};
+            } else {
+                op = {2, emailBase + emailDist(random), groupBase + groupDist(random)};
+            }
+        }
+        return trace;
+    }
+
+    bool save(const std::string& filename) const {
+        std::string payload;
+        for (const auto& s : strings) {
+            uint32_t length = static_cast<uint32_t>(s.size());
+            payload.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        }
+        size_t stringBytes = 0;
+        for (const auto& s : strings) {
+            payload += s;
+            stringBytes += s.size();
+        }
+        for (const auto& op : operations) {
+            PackedOperation packed{op.type, op.first, op.second};
+            payload.append(reinterpret_cast<const char*>(&packed), sizeof(packed));
+        }
+
+        TraceHeader header;
+        std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+        header.version = TRACE_VERSION;
+        header.findWeight = config.findWeight;
+        header.groupsWeight = config.groupsWeight;
+        header.updateWeight = config.updateWeight;
+        header.seed = config.seed;
+        header.nameSkew = config.nameSkew;
+        header.emailSkew = config.emailSkew;
+        header.datasetSize = datasetSize;
+        header.stringCount = strings.size();
+        header.stringBytes = stringBytes;
+        header.operationCount = operations.size();
+        header.checksum = snapshotChecksum(payload.data(), payload.size());
+
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(payload.data(), payload.size());
+        return static_cast<bool>(file);
+    }
+
+    // Replaces this trace with the one in `filename`; false if the file is
+    // missing, corrupt or refers to strings it does not contain
+    bool load(const std::string& filename) {
+        std::ifstream file(filename, std::ios::binary);
+        TraceHeader header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+        if (std::memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0) return false;
+        if (header.version != TRACE_VERSION) return false;
+
+        std::string payload((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        size_t expected = header.stringCount * sizeof(uint32_t) + header.stringBytes +
+                          header.operationCount * sizeof(PackedOperation);
+        if (payload.size() != expected) return false;
+        if (snapshotChecksum(payload.data(), payload.size()) != header.checksum) return false;
+
+        const char* pos = payload.data();
+        const char* bytes = pos + header.stringCount * sizeof(uint32_t);
+        std::vector<std::string> loadedStrings(header.stringCount);
+        size_t offset = 0;
+        for (auto& s : loadedStrings) {
+            uint32_t length;
+            std::memcpy(&length, pos, sizeof(length));
+            pos += sizeof(length);
+            if (offset + length > header.stringBytes) return false;
+            s.assign(bytes + offset, length);
+            offset += length;
+        }
+
+        pos = bytes + header.stringBytes;
+        std::vector<TraceOperation> loadedOperations(header.operationCount);
+        for (auto& op : loadedOperations) {
+            PackedOperation packed;
+            std::memcpy(&packed, pos, sizeof(packed));
+            pos += sizeof(packed);
+            if (packed.type > 2) return false;
+            if (packed.type != 1 && (packed.first >= header.stringCount || packed.second >= header.stringCount)) return false;
+            op = {static_cast<uint8_t>(packed.type), packed.first, packed.second};
+        }
+
+        config.seed = header.seed;
+        config.findWeight = header.findWeight;
+        config.groupsWeight = header.groupsWeight;
+        config.updateWeight = header.updateWeight;
+        config.nameSkew = header.nameSkew;
+        config.emailSkew = header.emailSkew;
+        datasetSize = header.datasetSize;
+        strings.swap(loadedStrings);
+        operations.swap(loadedOperations);
+        return true;
+    }
+};
+
+#endif
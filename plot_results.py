@@ -24,11 +24,53 @@ def plot_benchmark_results():
     # Define colors for each variant
     colors = {'Variant1_HashMap': '#2ecc71', 
               'Variant2_Mixed': '#e74c3c', 
-              'Variant3_Map_BST': '#3498db'}
+              'Variant3_Map_BST': '#3498db',
+              'Variant4_Columnar': '#f1c40f',
+              'Variant5_Arena': '#8e44ad',
+              'Variant6_FlatHash': '#1abc9c',
+              'Variant7_Concurrent': '#e67e22',
+              'Variant8_Mapped': '#34495e',
+              'Variant1_HashMap_IncDup': '#27ae60',
+              'Variant2_Mixed_IncDup': '#c0392b',
+              'Variant3_Map_BST_IncDup': '#2980b9',
+              'Variant1_HashMap_Bloom': '#82e0aa',
+              'Variant2_Mixed_Bloom': '#f1948a',
+              'Variant3_Map_BST_Bloom': '#85c1e9',
+              'Variant4_Columnar_Bloom': '#f7dc6f',
+              'Variant5_Arena_Bloom': '#bb8fce',
+              'Variant6_FlatHash_Bloom': '#76d7c4',
+              'Variant1_HashMap_PerfectEmail': '#196f3d',
+              'Variant2_Mixed_PerfectEmail': '#922b21',
+              'Variant3_Map_BST_PerfectEmail': '#1f618d',
+              'Variant4_Columnar_PerfectEmail': '#b7950b',
+              'Variant5_Arena_PerfectEmail': '#6c3483',
+              'Variant6_FlatHash_PerfectEmail': '#117864',
+              'Variant7_Concurrent_PerfectEmail': '#af601a'}
     
     labels = {'Variant1_HashMap': 'Variant 1: HashMap (unordered_map)', 
               'Variant2_Mixed': 'Variant 2: Mixed (vector + hash)', 
-              'Variant3_Map_BST': 'Variant 3: Map/BST (std::map)'}
+              'Variant3_Map_BST': 'Variant 3: Map/BST (std::map)',
+              'Variant4_Columnar': 'Variant 4: Columnar (dictionary encoded)',
+              'Variant5_Arena': 'Variant 5: HashMap over string arena',
+              'Variant6_FlatHash': 'Variant 6: Flat hash (SwissTable style)',
+              'Variant7_Concurrent': 'Variant 7: Concurrent (striped locks)',
+              'Variant8_Mapped': 'Variant 8: served from a mapped snapshot',
+              'Variant1_HashMap_IncDup': 'Variant 1 + incremental duplicates',
+              'Variant2_Mixed_IncDup': 'Variant 2 + incremental duplicates',
+              'Variant3_Map_BST_IncDup': 'Variant 3 + incremental duplicates',
+              'Variant1_HashMap_Bloom': 'Variant 1 + name filter',
+              'Variant2_Mixed_Bloom': 'Variant 2 + name filter',
+              'Variant3_Map_BST_Bloom': 'Variant 3 + name filter',
+              'Variant4_Columnar_Bloom': 'Variant 4 + name filter',
+              'Variant5_Arena_Bloom': 'Variant 5 + name filter',
+              'Variant6_FlatHash_Bloom': 'Variant 6 + name filter',
+              'Variant1_HashMap_PerfectEmail': 'Variant 1 + perfect email index',
+              'Variant2_Mixed_PerfectEmail': 'Variant 2 + perfect email index',
+              'Variant3_Map_BST_PerfectEmail': 'Variant 3 + perfect email index',
+              'Variant4_Columnar_PerfectEmail': 'Variant 4 + perfect email index',
+              'Variant5_Arena_PerfectEmail': 'Variant 5 + perfect email index',
+              'Variant6_FlatHash_PerfectEmail': 'Variant 6 + perfect email index',
+              'Variant7_Concurrent_PerfectEmail': 'Variant 7 + perfect email index'}
     
     # Plot 1: Operations per 10 seconds
     ax1 = axes[0, 0]
@@ -51,9 +93,12 @@ def plot_benchmark_results():
         ax2.plot(variant_data['DatasetSize'], variant_data['MemoryKB'], 
                 marker='s', linewidth=2, markersize=8,
                 label=labels[variant], color=colors[variant])
+        ax2.plot(variant_data['DatasetSize'], variant_data['MeasuredKB'],
+                marker='s', linewidth=1, markersize=5, linestyle='--',
+                color=colors[variant])
     ax2.set_xlabel('Dataset Size (records)', fontweight='bold')
     ax2.set_ylabel('Memory Usage (KB)', fontweight='bold')
-    ax2.set_title('Memory Consumption')
+    ax2.set_title('Memory Consumption (solid: estimate, dashed: measured heap)')
     ax2.set_xscale('log')
     ax2.set_yscale('log')
     ax2.grid(True, alpha=0.3)
@@ -101,20 +146,280 @@ def plot_benchmark_results():
         for _, row in size_data.iterrows():
             print(f"  {labels[row['Variant']]}:")
             print(f"    Operations/10s: {row['OperationsCount']}")
-            print(f"    Memory: {row['MemoryKB']} KB")
-            print(f"    Load time: {row['LoadTime']:.4f} s")
+            print(f"    Memory: {row['MemoryKB']} KB estimated, {row['MeasuredKB']} KB measured heap "
+                  f"(measured RSS: {row['RssKB']} KB)")
+            print(f"      students {row['StudentsKB']} KB / {row['StudentsAllocations']} allocations, "
+                  f"name index {row['NameIndexKB']} KB / {row['NameIndexAllocations']}, "
+                  f"email index {row['EmailIndexKB']} KB / {row['EmailIndexAllocations']}, "
+                  f"other {row['OtherKB']} KB / {row['OtherAllocations']}")
+            print(f"    Load time: {row['LoadTime']:.4f} s ({row['LoadAllocations']} allocations)")
+            print(f"    Find latency: p50 {row['FindP50Ns']} ns, p99 {row['FindP99Ns']} ns, p99.9 {row['FindP999Ns']} ns")
+            print(f"    Update latency: p50 {row['UpdateP50Ns']} ns, p99 {row['UpdateP99Ns']} ns, p99.9 {row['UpdateP999Ns']} ns")
+            if row['FilterKB'] > 0:
+                print(f"    Name filter: {row['FilterKB']} KB, false positive rate {row['FilterFPR'] * 100:.2f}%")
+
+
+def plot_latency_results():
+    # Per-operation latency percentiles from the trace replay, largest dataset
+    df = pd.read_csv('build/benchmark_results.csv')
+    largest = df['DatasetSize'].max()
+    df_largest = df[df['DatasetSize'] == largest]
+    percentiles = [('P50Ns', 'p50'), ('P90Ns', 'p90'), ('P99Ns', 'p99'), ('P999Ns', 'p99.9'), ('MaxNs', 'max')]
+    operations = [('Find', 'Operation 1: find by name'), ('Groups', 'Operation 2: duplicate groups'),
+                  ('Update', 'Operation 3: update group')]
+
+    fig, axes = plt.subplots(1, len(operations), figsize=(6 * len(operations), 6))
+    fig.suptitle(f'Latency Percentiles per Operation ({largest} records)', fontsize=14, fontweight='bold')
+
+    variants = df_largest['Variant'].unique()
+    x = np.arange(len(percentiles))
+    width = 0.8 / len(variants)
+    for ax, (op, title) in zip(axes, operations):
+        for i, variant in enumerate(variants):
+            row = df_largest[df_largest['Variant'] == variant].iloc[0]
+            values = [max(row[op + column], 1) for column, _ in percentiles]
+            ax.bar(x + (i - len(variants) / 2 + 0.5) * width, values, width, label=variant)
+        ax.set_xticks(x)
+        ax.set_xticklabels([label for _, label in percentiles])
+        ax.set_ylabel('Latency (ns)', fontweight='bold')
+        ax.set_title(title)
+        ax.set_yscale('log')
+        ax.grid(True, alpha=0.3, axis='y')
+    axes[0].legend(fontsize=7)
+
+    plt.tight_layout()
+    plt.savefig('latency_percentiles.png', dpi=300, bbox_inches='tight')
+    print("Saved: latency_percentiles.png")
+    plt.close()
+
+
+def plot_perf_results():
+    # Hardware counters per load phase (per row) and per operation, largest dataset;
+    # columns are empty unless the benchmark ran with --perf and the counters were available
+    df = pd.read_csv('build/benchmark_results.csv')
+    largest = df['DatasetSize'].max()
+    df_largest = df[df['DatasetSize'] == largest]
+    scopes = ['Parse', 'Append', 'Build', 'Find', 'Groups', 'Update']
+    events = ['Cycles', 'Instructions', 'L1Misses', 'LlcMisses', 'BranchMisses', 'PageFaults']
+    events = [e for e in events if df_largest[[s + e for s in scopes]].notna().any().any()]
+    if not events:
+        print("No performance counter columns, skipping perf_counters.png (run with --perf)")
+        return
+
+    fig, axes = plt.subplots(1, len(events), figsize=(6 * len(events), 6), squeeze=False)
+    fig.suptitle(f'Hardware Counters per Row (load) and per Operation ({largest} records)',
+                 fontsize=14, fontweight='bold')
+
+    variants = df_largest['Variant'].unique()
+    x = np.arange(len(scopes))
+    width = 0.8 / len(variants)
+    for ax, event in zip(axes[0], events):
+        for i, variant in enumerate(variants):
+            row = df_largest[df_largest['Variant'] == variant].iloc[0]
+            values = [max(row[scope + event], 0.001) if pd.notna(row[scope + event]) else 0 for scope in scopes]
+            ax.bar(x + (i - len(variants) / 2 + 0.5) * width, values, width, label=variant)
+        ax.set_xticks(x)
+        ax.set_xticklabels(scopes)
+        ax.set_title(event)
+        ax.set_yscale('log')
+        ax.grid(True, alpha=0.3, axis='y')
+    axes[0][0].legend(fontsize=7)
+
+    plt.tight_layout()
+    plt.savefig('perf_counters.png', dpi=300, bbox_inches='tight')
+    print("Saved: perf_counters.png")
+    plt.close()
+
+
+def plot_load_results():
+    # Read parallel load benchmark data
+    df_load = pd.read_csv('build/load_results.csv')
+    sizes = sorted(df_load['DatasetSize'].unique())
+
+    fig, axes = plt.subplots(1, len(sizes), figsize=(5 * len(sizes), 5), squeeze=False)
+    fig.suptitle('Parallel Load Scaling (loadFromFileParallel)', fontsize=14, fontweight='bold')
+
+    for ax, size in zip(axes[0], sizes):
+        size_data = df_load[df_load['DatasetSize'] == size]
+        for variant in size_data['Variant'].unique():
+            variant_data = size_data[size_data['Variant'] == variant]
+            ax.plot(variant_data['Threads'], variant_data['LoadTime'],
+                    marker='o', linewidth=2, markersize=8, label=variant)
+        ax.set_xlabel('Threads', fontweight='bold')
+        ax.set_ylabel('Load Time (seconds)', fontweight='bold')
+        ax.set_title(f'{size} records')
+        ax.set_xscale('log', base=2)
+        ax.grid(True, alpha=0.3)
+        ax.legend()
+
+    plt.tight_layout()
+    plt.savefig('load_scaling.png', dpi=300, bbox_inches='tight')
+    print("Saved: load_scaling.png")
+    plt.close()
+
+
+def plot_pipeline_results():
+    # Serial load against the read/parse/index pipeline, largest dataset
+    df_pipe = pd.read_csv('build/pipeline_results.csv')
+    size = df_pipe['DatasetSize'].max()
+    data = df_pipe[df_pipe['DatasetSize'] == size]
+    variants = list(data['Variant'])
+    x = np.arange(len(variants))
+
+    fig, axes = plt.subplots(1, 2, figsize=(16, 6))
+    fig.suptitle(f'Pipelined load ({size} records, {data["ParserThreads"].iloc[0]} parser threads)',
+                 fontsize=14, fontweight='bold')
+
+    width = 0.35
+    axes[0].bar(x - width / 2, data['SerialLoadTime'], width, label='loadFromFile')
+    axes[0].bar(x + width / 2, data['PipelineLoadTime'], width, label='PipelinedLoader')
+    axes[0].set_ylabel('Load Time (seconds)', fontweight='bold')
+    axes[0].set_title('Serial vs. pipelined')
+
+    # Busy time per stage; parse time is summed over the parser threads
+    stages = ['ReadTime', 'ParseTime', 'IndexTime', 'BuildTime', 'WaitTime']
+    width = 0.16
+    for i, stage in enumerate(stages):
+        axes[1].bar(x + (i - 2) * width, data[stage], width, label=stage.replace('Time', ''))
+    axes[1].set_ylabel('Time (seconds)', fontweight='bold')
+    axes[1].set_title('Time per stage')
+
+    for ax in axes:
+        ax.set_xticks(x)
+        ax.set_xticklabels(variants, rotation=30, ha='right')
+        ax.legend()
+        ax.grid(True, alpha=0.3, axis='y')
+
+    plt.tight_layout()
+    plt.savefig('pipeline_comparison.png', dpi=300, bbox_inches='tight')
+    print("Saved: pipeline_comparison.png")
+    plt.close()
+
+
+def plot_concurrent_results():
+    # Read multi-threaded operation benchmark data
+    df_conc = pd.read_csv('build/concurrent_results.csv')
+    sizes = sorted(df_conc['DatasetSize'].unique())
+
+    fig, axes = plt.subplots(1, len(sizes), figsize=(5 * len(sizes), 5), squeeze=False)
+    fig.suptitle('Concurrent Throughput (A:B:C = 5:5:50, shared database)', fontsize=14, fontweight='bold')
+
+    for ax, size in zip(axes[0], sizes):
+        size_data = df_conc[df_conc['DatasetSize'] == size]
+        for variant in size_data['Variant'].unique():
+            variant_data = size_data[size_data['Variant'] == variant]
+            ax.plot(variant_data['Threads'], variant_data['OpsPerSecond'],
+                    marker='o', linewidth=2, markersize=8, label=variant)
+        ax.set_xlabel('Threads', fontweight='bold')
+        ax.set_ylabel('Aggregate ops/s', fontweight='bold')
+        ax.set_title(f'{size} records')
+        ax.set_xscale('log', base=2)
+        ax.grid(True, alpha=0.3)
+        ax.legend()
+
+    plt.tight_layout()
+    plt.savefig('concurrent_scaling.png', dpi=300, bbox_inches='tight')
+    print("Saved: concurrent_scaling.png")
+    plt.close()
+
+
+def plot_batch_results():
+    # Read single call vs batch API throughput
+    df_batch = pd.read_csv('build/batch_results.csv')
+
+    fig, axes = plt.subplots(1, 2, figsize=(14, 5))
+    fig.suptitle('Batched API with prefetching (single calls dashed)', fontsize=14, fontweight='bold')
+
+    for ax, (single, batch, title) in zip(axes, [('SingleLookupsPerSec', 'BatchLookupsPerSec', 'Operation 1: lookups'),
+                                                  ('SingleUpdatesPerSec', 'BatchUpdatesPerSec', 'Operation 3: updates')]):
+        for variant in df_batch['Variant'].unique():
+            variant_data = df_batch[df_batch['Variant'] == variant]
+            line, = ax.plot(variant_data['DatasetSize'], variant_data[batch],
+                            marker='o', linewidth=2, markersize=8, label=f'{variant} (batch)')
+            ax.plot(variant_data['DatasetSize'], variant_data[single],
+                    linestyle='--', marker='x', color=line.get_color(), label=f'{variant} (single)')
+        ax.set_xlabel('Dataset Size (records)', fontweight='bold')
+        ax.set_ylabel('Requests per second', fontweight='bold')
+        ax.set_title(title)
+        ax.set_xscale('log')
+        ax.grid(True, alpha=0.3)
+        ax.legend(fontsize=8)
+
+    plt.tight_layout()
+    plt.savefig('batch_comparison.png', dpi=300, bbox_inches='tight')
+    print("Saved: batch_comparison.png")
+    plt.close()
+
+
+def plot_durability_results():
+    # Throughput and update latency of the mix per commit policy of the change log
+    df_durable = pd.read_csv('build/durability_results.csv')
+
+    fig, axes = plt.subplots(1, 2, figsize=(14, 5))
+    fig.suptitle('Durable updates: cost of each fsync policy (Variant 1)', fontsize=14, fontweight='bold')
+
+    sizes = sorted(df_durable['DatasetSize'].unique())
+    policies = list(df_durable['Policy'].unique())
+    x = np.arange(len(policies))
+    width = 0.8 / len(sizes)
+    for i, size in enumerate(sizes):
+        size_data = df_durable[df_durable['DatasetSize'] == size].set_index('Policy').reindex(policies)
+        offset = (i - len(sizes) / 2 + 0.5) * width
+        axes[0].bar(x + offset, size_data['OpsPerSecond'], width, label=f'{size} records')
+        axes[1].bar(x + offset, size_data['UpdateP99Ns'], width, label=f'{size} records')
+    for ax, ylabel, title in [(axes[0], 'Operations per second', 'Throughput of the mix'),
+                              (axes[1], 'Latency (ns)', 'Operation 3 p99 latency')]:
+        ax.set_xticks(x)
+        ax.set_xticklabels(policies, rotation=30)
+        ax.set_ylabel(ylabel, fontweight='bold')
+        ax.set_title(title)
+        ax.grid(True, alpha=0.3, axis='y')
+        ax.legend(fontsize=8)
+    axes[1].set_yscale('log')
+
+    plt.tight_layout()
+    plt.savefig('durability_comparison.png', dpi=300, bbox_inches='tight')
+    print("Saved: durability_comparison.png")
+    plt.close()
+
+
+def plot_incremental_results():
+    # Applying a 1% delta in place against reloading the whole dataset (one marker per variant)
+    df_inc = pd.read_csv('build/incremental_results.csv')
+
+    fig, ax = plt.subplots(figsize=(10, 6))
+    fig.suptitle('Incremental ingestion: 1% delta vs. full reload', fontsize=14, fontweight='bold')
+    for variant, marker in zip(df_inc['Variant'].unique(), ['o', 's', '^', 'D', 'v', 'P', 'X']):
+        data = df_inc[df_inc['Variant'] == variant]
+        ax.plot(data['DatasetSize'], data['AppendTime'] + data['RemoveTime'], marker=marker, linewidth=2,
+                label=f'{variant}: upserts + removals')
+        ax.plot(data['DatasetSize'], data['ReloadTime'], marker=marker, linewidth=2, linestyle='--',
+                label=f'{variant}: full reload')
+    ax.set_xlabel('Dataset Size (records)', fontweight='bold')
+    ax.set_ylabel('Time (seconds)', fontweight='bold')
+    ax.set_xscale('log')
+    ax.set_yscale('log')
+    ax.legend(fontsize=8)
+    ax.grid(True, alpha=0.3)
+
+    plt.tight_layout()
+    plt.savefig('incremental_comparison.png', dpi=300, bbox_inches='tight')
+    print("Saved: incremental_comparison.png")
+    plt.close()
 
 
 def plot_sort_results():
     # Read sort benchmark data
-    df_sort = pd.read_csv('build/sort_results.csv')
+    df_all = pd.read_csv('build/sort_results.csv')
+    df_sort = df_all[df_all['Threads'] == 1]
     
     # Replace zeros with small value for log plotting (timer precision issue)
     df_sort_plot = df_sort.copy()
     df_sort_plot.loc[df_sort_plot['StandardSort'] == 0, 'StandardSort'] = 0.00005
     df_sort_plot.loc[df_sort_plot['RadixSort'] == 0, 'RadixSort'] = 0.00005
+    df_sort_plot.loc[df_sort_plot['ExternalSort'] == 0, 'ExternalSort'] = 0.00005
     
-    fig, ax = plt.subplots(1, 1, figsize=(10, 6))
+    fig, (ax, ax_threads) = plt.subplots(1, 2, figsize=(16, 6))
     fig.suptitle('Sorting Algorithm Comparison (Task S4: Sort by Surname, Name)', 
                  fontsize=14, fontweight='bold')
     
@@ -125,6 +430,9 @@ def plot_sort_results():
     ax.plot(df_sort_plot['DatasetSize'], df_sort_plot['RadixSort'], 
             marker='s', linewidth=2, markersize=8,
             label='Radix Sort (MSD)', color='#f39c12')
+    ax.plot(df_sort_plot['DatasetSize'], df_sort_plot['ExternalSort'],
+            marker='^', linewidth=2, markersize=8,
+            label='External Sort (16 MB budget)', color='#16a085')
     
     ax.set_xlabel('Dataset Size (records)', fontweight='bold')
     ax.set_ylabel('Time (seconds)', fontweight='bold')
@@ -138,6 +446,22 @@ def plot_sort_results():
     ax.text(0.02, 0.98, 'Note: Values < 0.0001s capped at 0.00005s (timer precision limit)', 
             transform=ax.transAxes, fontsize=8, verticalalignment='top',
             bbox=dict(boxstyle='round', facecolor='wheat', alpha=0.3))
+
+    # Thread scaling on the largest dataset (past 1 thread: parallel merge sort, parallel radix sort)
+    largest = df_all['DatasetSize'].max()
+    df_largest = df_all[df_all['DatasetSize'] == largest]
+    ax_threads.plot(df_largest['Threads'], df_largest['StandardSort'],
+                    marker='o', linewidth=2, markersize=8,
+                    label='std::sort / parallel merge sort', color='#9b59b6')
+    ax_threads.plot(df_largest['Threads'], df_largest['RadixSort'],
+                    marker='s', linewidth=2, markersize=8,
+                    label='Radix Sort (MSD, parallel)', color='#f39c12')
+    ax_threads.set_xlabel('Threads', fontweight='bold')
+    ax_threads.set_ylabel('Time (seconds)', fontweight='bold')
+    ax_threads.set_title(f'Thread Scaling ({largest} records)')
+    ax_threads.set_xscale('log', base=2)
+    ax_threads.legend()
+    ax_threads.grid(True, alpha=0.3)
     
     plt.tight_layout()
     plt.savefig('sort_comparison.png', dpi=300, bbox_inches='tight')
@@ -150,12 +474,23 @@ def plot_sort_results():
         print(f"\nDataset: {row['DatasetSize']} records")
         print(f"  Standard Sort: {row['StandardSort']:.4f} s")
         print(f"  Radix Sort: {row['RadixSort']:.4f} s")
+        print(f"  External Sort: {row['ExternalSort']:.4f} s")
         speedup = row['StandardSort'] / row['RadixSort']
         print(f"  Speedup: {speedup:.2f}x {'(Radix faster)' if speedup > 1 else '(Standard faster)'}")
+        for _, scaled in df_all[(df_all['DatasetSize'] == row['DatasetSize']) & (df_all['Threads'] > 1)].iterrows():
+            print(f"  {scaled['Threads']} threads: merge {scaled['StandardSort']:.4f} s, radix {scaled['RadixSort']:.4f} s")
 
 
 if __name__ == '__main__':
     print("Generating benchmark visualizations...")
     plot_benchmark_results()
+    plot_latency_results()
+    plot_perf_results()
+    plot_load_results()
+    plot_pipeline_results()
+    plot_concurrent_results()
+    plot_batch_results()
+    plot_durability_results()
+    plot_incremental_results()
     plot_sort_results()
-    print("\nDone! Check benchmark_comparison.png and sort_comparison.png")
+    print("\nDone! Check benchmark_comparison.png, latency_percentiles.png, perf_counters.png, load_scaling.png, pipeline_comparison.png, concurrent_scaling.png, batch_comparison.png, durability_comparison.png, incremental_comparison.png and sort_comparison.png")
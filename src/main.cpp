@@ -1,11 +1,94 @@
 #include "Student.h"
 #include "Database.h"
 #include "Sorter.h"
+#include "ExternalSorter.h"
+#include "CsvReader.h"
+#include "CsvWriter.h"
+#include "ColumnarDB.h"
+#include "ArenaDB.h"
+#include "FlatHashDB.h"
+#include "ConcurrentDB.h"
+#include "MappedDB.h"
+#include "DurableDB.h"
+#include "AllocationCounter.h"
+#include "LatencyHistogram.h"
+#include "Workload.h"
+#include "PerfCounters.h"
+#include "PipelinedLoader.h"
 #include <iostream>
 #include <fstream>
 #include <chrono>
 #include <random>
 #include <iomanip>
+#include <sstream>
+#include <cstdio>
+#include <malloc.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+
+// Count every allocation so loads can report how many they made, and charge
+// its bytes to the allocating thread's AllocationTag. Each block carries a
+// header with its size and tag, so frees are charged back without asking malloc.
+// noinline keeps GCC from pairing the inlined free() with new expressions.
+struct AllocationHeader {
+    size_t size;
+    size_t tag;
+};
+static_assert(sizeof(AllocationHeader) == __STDCPP_DEFAULT_NEW_ALIGNMENT__, "header must keep new's alignment");
+
+static void* tagAllocation(void* block, size_t offset, size_t size) {
+    char* p = static_cast<char*>(block) + offset;
+    AllocationTag tag = AllocationCounter::currentTag;
+    new (p - sizeof(AllocationHeader)) AllocationHeader{size, static_cast<size_t>(tag)};
+    AllocationCounter::allocated(size, tag);
+    return p;
+}
+
+static void untagAllocation(void* p) {
+    auto* header = reinterpret_cast<AllocationHeader*>(static_cast<char*>(p) - sizeof(AllocationHeader));
+    AllocationCounter::freed(header->size, static_cast<AllocationTag>(header->tag));
+}
+
+void* operator new(size_t size) {
+    if (void* block = std::malloc(sizeof(AllocationHeader) + size)) {
+        return tagAllocation(block, sizeof(AllocationHeader), size);
+    }
+    throw std::bad_alloc();
+}
+
+// Over-aligned types (BloomFilter blocks, ConcurrentDB stripes): the header
+// sits at the end of a full alignment unit in front of the block
+void* operator new(size_t size, std::align_val_t alignment) {
+    size_t align = std::max(static_cast<size_t>(alignment), sizeof(AllocationHeader));
+    size_t total = (align + size + align - 1) / align * align;
+    if (void* block = std::aligned_alloc(align, total)) {
+        return tagAllocation(block, align, size);
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    if (!p) return;
+    untagAllocation(p);
+    std::free(static_cast<char*>(p) - sizeof(AllocationHeader));
+}
+
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::align_val_t alignment) noexcept {
+    if (!p) return;
+    untagAllocation(p);
+    size_t align = std::max(static_cast<size_t>(alignment), sizeof(AllocationHeader));
+    std::free(static_cast<char*>(p) - align);
+}
+
+__attribute__((noinline)) void operator delete(void* p, size_t, std::align_val_t alignment) noexcept {
+    operator delete(p, alignment);
+}
 
 class DataHelper {
 private:
@@ -15,111 +98,377 @@ private:
     std::vector<std::string> uniqueSurnames;
     std::vector<std::string> uniqueGroups;
     std::vector<std::string> uniqueEmails;
+    std::map<std::string, size_t> writtenSubsets;  // file -> rows, written by this run
 
 public:
-    DataHelper() : rng(std::random_device{}()) {}
+    explicit DataHelper(uint64_t seed) : rng(seed) {}
 
     void loadFullDataset(const std::string& filename) {
-        std::ifstream file(filename);
-        std::string line;
-        bool firstLine = true;
+        CsvReader reader(filename);
         
         std::set<std::string> names, surnames, groups;
         
-        while (std::getline(file, line)) {
-            if (line.empty()) continue;
-            if (firstLine && line.find("m_name") == 0) {
-                firstLine = false;
-                continue;
-            }
-            firstLine = false;
-            
-            Student s = Student::fromCSV(line);
-            allStudents.push_back(s);
+        reader.forEachStudent([&](Student&& s) {
             names.insert(s.m_name);
             surnames.insert(s.m_surname);
             groups.insert(s.m_group);
             uniqueEmails.push_back(s.m_email);
-        }
+            allStudents.push_back(std::move(s));
+        });
         
         uniqueNames.assign(names.begin(), names.end());
         uniqueSurnames.assign(surnames.begin(), surnames.end());
         uniqueGroups.assign(groups.begin(), groups.end());
     }
 
-    void createSubset(const std::string& outputFile, size_t count) {
-        std::ofstream file(outputFile);
-        for (size_t i = 0; i < std::min(count, allStudents.size()); i++) {
-            file << allStudents[i].toCSV() << "\n";
+    // First count rows of the dataset; with repeat, cycles through it until count rows are written.
+    // A file this run already wrote with the same rows is reused as is.
+    void createSubset(const std::string& outputFile, size_t count, bool repeat = false) {
+        size_t rows = repeat && !allStudents.empty() ? count : std::min(count, allStudents.size());
+        auto written = writtenSubsets.find(outputFile);
+        if (written != writtenSubsets.end() && written->second == rows) return;
+
+        CsvWriter writer(outputFile);
+        for (size_t i = 0; i < rows; i++) {
+            writer.writeStudent(allStudents[i % allStudents.size()]);
         }
+        if (writer.close()) writtenSubsets[outputFile] = rows;
     }
 
-    std::string getRandomName() {
+    // Draws from gen, so each benchmark thread can use its own generator
+    std::string getRandomName(std::mt19937& gen) const {
         std::uniform_int_distribution<> dist(0, uniqueNames.size() - 1);
-        return uniqueNames[dist(rng)];
+        return uniqueNames[dist(gen)];
     }
 
-    std::string getRandomSurname() {
+    std::string getRandomSurname(std::mt19937& gen) const {
         std::uniform_int_distribution<> dist(0, uniqueSurnames.size() - 1);
-        return uniqueSurnames[dist(rng)];
+        return uniqueSurnames[dist(gen)];
     }
 
-    std::string getRandomEmail(size_t maxId) {
+    std::string getRandomEmail(size_t maxId, std::mt19937& gen) const {
         std::uniform_int_distribution<> dist(0, std::min(maxId, uniqueEmails.size()) - 1);
-        return uniqueEmails[dist(rng)];
+        return uniqueEmails[dist(gen)];
     }
 
-    std::string getRandomGroup() {
+    std::string getRandomGroup(std::mt19937& gen) const {
         std::uniform_int_distribution<> dist(0, uniqueGroups.size() - 1);
-        return uniqueGroups[dist(rng)];
+        return uniqueGroups[dist(gen)];
     }
+
+    const std::vector<std::string>& names() const { return uniqueNames; }
+    const std::vector<std::string>& surnames() const { return uniqueSurnames; }
+    const std::vector<std::string>& emails() const { return uniqueEmails; }
+    const std::vector<std::string>& groups() const { return uniqueGroups; }
+    const std::vector<Student>& students() const { return allStudents; }
+
+    std::string getRandomName() { return getRandomName(rng); }
+    std::string getRandomSurname() { return getRandomSurname(rng); }
+    std::string getRandomEmail(size_t maxId) { return getRandomEmail(maxId, rng); }
+    std::string getRandomGroup() { return getRandomGroup(rng); }
+};
+
+// Command line settings of a benchmark run
+struct BenchmarkOptions {
+    WorkloadConfig workload;
+    std::vector<size_t> sizes = {100, 1000, 10000, 100000};
+    double timeLimit = 10.0;           // per variant; 0 replays each trace exactly once
+    size_t traceLength = 1 << 20;
+    std::string saveTracePrefix;       // write <prefix>_<size>.trace
+    std::string replayTracePrefix;     // replay <prefix>_<size>.trace instead of generating
+    double perfTime = 0.0;             // counter profiling time per operation type; 0 disables it
+    DatabaseOptions optionRuns;        // options whose runs are added to the main matrix; none by default
 };
 
 class Benchmark {
 private:
+    BenchmarkOptions options;
     DataHelper dataHelper;
+    WorkloadTrace trace;  // of the dataset size being benchmarked
     std::ofstream benchmarkFile;
+    std::unique_ptr<PerfCounters> perf;  // null unless profiling with at least one counter
 
-    size_t runOperations(IDatabase& db, size_t datasetSize, int A, int B, int C, double timeLimit) {
-        std::mt19937 rng(std::random_device{}());
-        std::discrete_distribution<> opDist({static_cast<double>(A), static_cast<double>(B), static_cast<double>(C)});
+    // Resident set size of the process, as reported by the kernel
+    static size_t currentRssBytes() {
+        std::ifstream statm("/proc/self/statm");
+        size_t totalPages = 0, residentPages = 0;
+        statm >> totalPages >> residentPages;
+        return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+
+    // One operation of the A:B:C mix; op is 0, 1 or 2
+    void runOperation(IDatabase& db, int op, size_t datasetSize, std::mt19937& gen, std::vector<size_t>& scratch) {
+        if (op == 0) {
+            // Operation 1: Find by name and surname
+            db.findRowsByNameSurname(dataHelper.getRandomName(gen), dataHelper.getRandomSurname(gen), scratch);
+        } else if (op == 1) {
+            // Operation 2: Find groups with duplicate name+surname
+            auto result = db.findGroupsWithDuplicateNameSurname();
+        } else {
+            // Operation 3: Update group by email
+            db.updateGroupByEmail(dataHelper.getRandomEmail(datasetSize, gen), dataHelper.getRandomGroup(gen));
+        }
+    }
+
+    static constexpr const char* OPERATION_LABELS[3] = {"Find", "Groups", "Update"};
+    static constexpr const char* PERF_SCOPES[6] = {"Parse", "Append", "Build", "Find", "Groups", "Update"};
+
+    // Structures whose measured heap is reported, in CSV column order
+    static constexpr AllocationTag STRUCTURE_TAGS[4] = {
+        AllocationTag::Students, AllocationTag::NameIndex, AllocationTag::EmailIndex, AllocationTag::Other};
+    static constexpr const char* STRUCTURE_LABELS[4] = {"Students", "NameIndex", "EmailIndex", "Other"};
+
+    void runTraceOperation(IDatabase& db, const TraceOperation& op, std::vector<size_t>& scratch) {
+        if (op.type == 0) {
+            db.findRowsByNameSurname(trace.strings[op.first], trace.strings[op.second], scratch);
+        } else if (op.type == 1) {
+            auto result = db.findGroupsWithDuplicateNameSurname();
+        } else {
+            db.updateGroupByEmail(trace.strings[op.first], trace.strings[op.second]);
+        }
+    }
+
+    // Replays the current trace and records every operation's latency by
+    // type: cycling through it for timeLimit seconds, or exactly once when
+    // timeLimit is 0. Only the operation sits between the two clock reads;
+    // the second one also serves the time limit check.
+    size_t runOperations(IDatabase& db, double timeLimit, std::array<LatencyHistogram, 3>& latencies) {
+        using Clock = std::chrono::steady_clock;
+        std::vector<size_t> scratch;
+        for (auto& histogram : latencies) {
+            histogram.clear();
+        }
 
-        auto startTime = std::chrono::high_resolution_clock::now();
         size_t opsCount = 0;
-        
-        while (true) {
-            auto currentTime = std::chrono::high_resolution_clock::now();
-            double elapsed = std::chrono::duration<double>(currentTime - startTime).count();
-            if (elapsed >= timeLimit) break;
-
-            int op = opDist(rng);
-            
-            if (op == 0) {
-                // Operation 1: Find by name and surname
-                auto result = db.findByNameSurname(dataHelper.getRandomName(), dataHelper.getRandomSurname());
-            } else if (op == 1) {
-                // Operation 2: Find groups with duplicate name+surname
-                auto result = db.findGroupsWithDuplicateNameSurname();
-            } else {
-                // Operation 3: Update group by email
-                db.updateGroupByEmail(dataHelper.getRandomEmail(datasetSize), dataHelper.getRandomGroup());
+        if (!trace.operations.empty()) {
+            bool once = timeLimit <= 0.0;
+            auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timeLimit));
+            for (size_t i = 0;; i = i + 1 < trace.operations.size() ? i + 1 : 0) {
+                const TraceOperation& op = trace.operations[i];
+                auto start = Clock::now();
+                runTraceOperation(db, op, scratch);
+                auto end = Clock::now();
+                latencies[op.type].record(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+                opsCount++;
+                if (once ? opsCount == trace.operations.size() : end >= deadline) break;
             }
-            
-            opsCount++;
         }
 
-        std::cout << "      Operations in 10s: " << opsCount << std::endl;
+        if (timeLimit > 0.0) {
+            std::cout << "      Operations in " << std::defaultfloat << timeLimit << "s: " << opsCount << std::endl;
+        } else {
+            std::cout << "      Operations replayed: " << opsCount << std::endl;
+        }
+        for (size_t type = 0; type < latencies.size(); type++) {
+            const LatencyHistogram& h = latencies[type];
+            std::cout << "      " << OPERATION_LABELS[type] << " latency (ns): p50 " << h.percentile(50)
+                      << ", p90 " << h.percentile(90) << ", p99 " << h.percentile(99)
+                      << ", p99.9 " << h.percentile(99.9) << ", max " << h.max() << std::endl;
+        }
         return opsCount;
     }
 
+    // Rows parsed between two counter reads of profileLoad: enough that the
+    // reads cost next to nothing per row
+    static constexpr size_t PROFILE_BATCH = 4096;
+
+    // Counters of a load of filename into db, split at the boundaries of its
+    // streaming load: parsing rows into batches, appendLoadedRows taking them
+    // (rows stored and whatever the variant indexes row by row) and endLoad
+    // (whatever it builds in one pass at the end). The counters are read
+    // around every batch, not inside the per-row loops. A variant without a
+    // streaming load is loaded with loadFromFile and reported as Build only.
+    std::array<PerfReading, 3> profileLoad(IDatabase& db, const std::string& filename) {
+        std::array<PerfReading, 3> phases;
+        PerfReading mark = perf->read();
+        if (!db.beginLoad()) {
+            db.loadFromFile(filename);
+            phases[2] = perf->read() - mark;
+            return phases;
+        }
+        phases.fill(mark - mark);
+
+        std::vector<Student> batch;
+        auto append = [&]() {
+            PerfReading parsed = perf->read();
+            phases[0] += parsed - mark;
+            db.appendLoadedRows(batch);
+            batch.clear();
+            mark = perf->read();
+            phases[1] += mark - parsed;
+        };
+        {
+            AllocationScope scope(AllocationTag::Students);
+            CsvReader(filename).forEachStudent([&](Student&& s) {
+                batch.push_back(std::move(s));
+                if (batch.size() == PROFILE_BATCH) append();
+            });
+        }
+        append();
+        db.endLoad();
+        phases[2] = perf->read() - mark;
+        return phases;
+    }
+
+    // Event counts per operation of each type: the trace's operations of one
+    // type run back to back, once through the trace or for perfTime seconds,
+    // with the counters read only before and after, so the read() calls do
+    // not disturb the caches of the operations they measure
+    std::array<PerfReading, 3> profileOperations(IDatabase& db) {
+        using Clock = std::chrono::steady_clock;
+        std::array<PerfReading, 3> perOperation;
+        std::vector<size_t> scratch;
+        for (uint8_t type = 0; type < perOperation.size(); type++) {
+            auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.perfTime));
+            size_t count = 0;
+            PerfReading start = perf->read();
+            for (const auto& op : trace.operations) {
+                if (op.type != type) continue;
+                runTraceOperation(db, op, scratch);
+                // Checking the clock every 64 operations keeps it out of the counts
+                if (++count % 64 == 0 && Clock::now() >= deadline) break;
+            }
+            PerfReading total = perf->read() - start;
+            for (size_t i = 0; i < PERF_EVENTS; i++) {
+                total.values[i] = count > 0 ? total.values[i] / count : 0.0;
+                total.valid[i] = total.valid[i] && count > 0;
+            }
+            perOperation[type] = total;
+        }
+        return perOperation;
+    }
+
+    // One CSV cell per event of reading / units, empty where not counted
+    static void writePerfColumns(std::ostream& out, const PerfReading& reading, double units) {
+        for (size_t i = 0; i < PERF_EVENTS; i++) {
+            out << ",";
+            if (reading.valid[i] && units > 0) out << std::fixed << std::setprecision(3) << reading.values[i] / units;
+        }
+    }
+
+    static void printPerf(const std::string& label, const PerfReading& reading, double units) {
+        std::cout << "      " << label << ":";
+        for (size_t i = 0; i < PERF_EVENTS; i++) {
+            if (reading.valid[i]) {
+                std::cout << " " << PERF_EVENT_LABELS[i] << " " << std::fixed << std::setprecision(3)
+                          << reading.values[i] / units;
+            }
+        }
+        if (reading.has(PerfEvent::Cycles) && reading.has(PerfEvent::Instructions) && reading[PerfEvent::Cycles] > 0) {
+            std::cout << " (IPC " << std::setprecision(2) << reading[PerfEvent::Instructions] / reading[PerfEvent::Cycles] << ")";
+        }
+        std::cout << std::endl;
+    }
+
+    // Runs the A:B:C mix on `threads` threads sharing db; returns the total operation count
+    size_t runConcurrentOperations(IDatabase& db, size_t datasetSize, size_t threads,
+                                   int A, int B, int C, double timeLimit) {
+        std::vector<size_t> counts(threads, 0);
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        parallelFor(threads, [&](size_t t) {
+            std::mt19937 gen(options.workload.seed + t);
+            std::discrete_distribution<> opDist({static_cast<double>(A), static_cast<double>(B), static_cast<double>(C)});
+            std::vector<size_t> scratch;
+            size_t opsCount = 0;
+            while (std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count() < timeLimit) {
+                runOperation(db, opDist(gen), datasetSize, gen, scratch);
+                opsCount++;
+            }
+            counts[t] = opsCount;
+        });
+
+        size_t total = 0;
+        for (size_t count : counts) {
+            total += count;
+        }
+        return total;
+    }
+
+    // Share of absent name|surname pairs the filter still lets through,
+    // measured on random pairs from the same distribution as operation 1
+    double measureFilterFalsePositives(const IDatabase& db, const BloomFilter& filter, size_t probes) {
+        std::vector<size_t> scratch;
+        size_t misses = 0, falsePositives = 0;
+        for (size_t i = 0; i < probes; i++) {
+            std::string name = dataHelper.getRandomName();
+            std::string surname = dataHelper.getRandomSurname();
+            if (db.findRowsByNameSurname(name, surname, scratch).empty()) {
+                misses++;
+                if (filter.mayContain(hashKeyParts(name, surname))) falsePositives++;
+            }
+        }
+        return misses > 0 ? static_cast<double>(falsePositives) / misses : 0.0;
+    }
+
 public:
+    explicit Benchmark(const BenchmarkOptions& options) : options(options), dataHelper(options.workload.seed) {
+        if (options.perfTime <= 0.0) return;
+        perf = std::make_unique<PerfCounters>();
+        if (!perf->available()) {
+            std::cerr << "Performance counters unavailable (perf_event_open failed); counter columns stay empty" << std::endl;
+            perf.reset();
+            return;
+        }
+        for (size_t i = 0; i < PERF_EVENTS; i++) {
+            if (!perf->has(static_cast<PerfEvent>(i))) {
+                std::cerr << "Performance counter " << PERF_EVENT_LABELS[i] << " unavailable; its columns stay empty" << std::endl;
+            }
+        }
+    }
+
     void loadData(const std::string& filename) {
         dataHelper.loadFullDataset(filename);
     }
 
+    // Generates (or loads, with a replay prefix) the trace every variant
+    // replays at this dataset size; false if a trace to replay is unusable
+    bool prepareWorkload(size_t datasetSize) {
+        std::string traceSuffix = "_" + std::to_string(datasetSize) + ".trace";
+        if (!options.replayTracePrefix.empty()) {
+            std::string filename = options.replayTracePrefix + traceSuffix;
+            if (!trace.load(filename)) {
+                std::cerr << "Cannot replay trace " << filename << std::endl;
+                return false;
+            }
+            std::cout << "Replaying " << filename << ": " << trace.operations.size() << " operations, seed "
+                      << trace.config.seed << std::endl;
+        } else {
+            // One seed per size, so a size's trace does not depend on which other sizes run
+            WorkloadConfig config = options.workload;
+            config.seed += datasetSize;
+            trace = WorkloadTrace::generate(config, options.traceLength, datasetSize, dataHelper.names(),
+                                            dataHelper.surnames(), dataHelper.emails(), dataHelper.groups());
+        }
+
+        if (!options.saveTracePrefix.empty()) {
+            std::string filename = options.saveTracePrefix + traceSuffix;
+            if (!trace.save(filename)) {
+                std::cerr << "Cannot write trace " << filename << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
     void openBenchmarkFile(const std::string& filename) {
         benchmarkFile.open(filename);
-        benchmarkFile << "Variant,DatasetSize,LoadTime,MemoryKB,OperationsCount" << std::endl;
+        benchmarkFile << "Variant,DatasetSize,LoadTime,LoadAllocations,SnapshotLoadTime,MemoryKB,MeasuredKB";
+        for (const char* label : STRUCTURE_LABELS) {
+            benchmarkFile << "," << label << "KB," << label << "Allocations";
+        }
+        benchmarkFile << ",RssKB,FilterKB,FilterFPR,OperationsCount";
+        for (const char* label : OPERATION_LABELS) {
+            benchmarkFile << "," << label << "P50Ns," << label << "P90Ns," << label << "P99Ns,"
+                          << label << "P999Ns," << label << "MaxNs";
+        }
+        // Counter columns: per row for the load phases, per operation for the operations
+        for (const char* scope : PERF_SCOPES) {
+            for (const char* event : PERF_EVENT_LABELS) {
+                benchmarkFile << "," << scope << event;
+            }
+        }
+        benchmarkFile << std::endl;
     }
 
     void closeBenchmarkFile() {
@@ -134,74 +483,576 @@ public:
         std::string filename = "test_" + std::to_string(datasetSize) + ".csv";
         dataHelper.createSubset(filename, datasetSize);
 
+        // Hand freed heap back to the OS so the RSS growth belongs to this load
+        malloc_trim(0);
+        size_t rssBefore = currentRssBytes();
+
+        std::array<AllocationUsage, 4> heapBefore;
+        for (size_t i = 0; i < heapBefore.size(); i++) {
+            heapBefore[i] = AllocationCounter::usage(STRUCTURE_TAGS[i]);
+        }
+        size_t allocationsBefore = AllocationCounter::count();
         auto loadStart = std::chrono::high_resolution_clock::now();
         db.loadFromFile(filename);
         auto loadEnd = std::chrono::high_resolution_clock::now();
         double loadTime = std::chrono::duration<double>(loadEnd - loadStart).count();
+        size_t loadAllocations = AllocationCounter::count() - allocationsBefore;
+
+        size_t rssAfter = currentRssBytes();
+        size_t rssKB = rssAfter > rssBefore ? (rssAfter - rssBefore) / 1024 : 0;
+
+        // Warm start: write a binary snapshot and load it back
+        std::string snapshotFile = "test_" + std::to_string(datasetSize) + ".snap";
+        double snapshotLoadTime = 0.0;
+        if (db.saveSnapshot(snapshotFile)) {
+            auto snapshotStart = std::chrono::high_resolution_clock::now();
+            db.loadSnapshot(snapshotFile);
+            auto snapshotEnd = std::chrono::high_resolution_clock::now();
+            snapshotLoadTime = std::chrono::duration<double>(snapshotEnd - snapshotStart).count();
+        }
 
         size_t memoryKB = db.getMemoryUsage() / 1024;
 
+        // Heap the loaded database holds, per structure, from the allocation hook
+        std::array<AllocationUsage, 4> heap;
+        int64_t measuredBytes = 0;
+        for (size_t i = 0; i < heap.size(); i++) {
+            heap[i] = AllocationCounter::usage(STRUCTURE_TAGS[i]) - heapBefore[i];
+            measuredBytes += heap[i].bytes;
+        }
+        int64_t measuredKB = measuredBytes / 1024;
+
         std::cout << "      Load time: " << std::fixed << std::setprecision(3) << loadTime << "s" << std::endl;
-        std::cout << "      Memory usage: " << memoryKB << " KB" << std::endl;
+        std::cout << "      Allocations during load: " << loadAllocations << std::endl;
+        std::cout << "      Snapshot load time: " << std::fixed << std::setprecision(3) << snapshotLoadTime << "s" << std::endl;
+        std::cout << "      Memory usage: " << memoryKB << " KB estimated, " << measuredKB << " KB measured" << std::endl;
+        for (size_t i = 0; i < heap.size(); i++) {
+            std::cout << "        " << STRUCTURE_LABELS[i] << ": " << heap[i].bytes / 1024 << " KB in "
+                      << heap[i].allocations << " allocations" << std::endl;
+        }
+        std::cout << "      Measured RSS growth: " << rssKB << " KB" << std::endl;
+
+        size_t filterKB = 0;
+        double filterFpr = 0.0;
+        if (const BloomFilter* filter = db.getNameFilter()) {
+            filterKB = filter->getMemoryUsage() / 1024;
+            filterFpr = measureFilterFalsePositives(db, *filter, 2000);
+            std::cout << "      Name filter: " << filterKB << " KB, false positive rate "
+                      << std::setprecision(2) << filterFpr * 100 << "% (estimated "
+                      << filter->estimatedFalsePositiveRate() * 100 << "%)" << std::endl;
+        }
 
-        // Run operations (A=5, B=5, C=50 from variant V1)
-        size_t opsCount = runOperations(db, datasetSize, 5, 5, 50, 10.0);
+        // Run operations (the trace's A:B:C mix, 5:5:50 from variant V1 unless configured)
+        std::array<LatencyHistogram, 3> latencies;
+        size_t opsCount = runOperations(db, options.timeLimit, latencies);
+
+        // Load phases per row and operations, from the hardware counters.
+        // The profiled load reloads the data the timed operations updated.
+        std::array<PerfReading, 6> counters;
+        if (perf) {
+            std::array<PerfReading, 3> phases = profileLoad(db, filename);
+            std::copy(phases.begin(), phases.end(), counters.begin());
+            std::array<PerfReading, 3> perOperation = profileOperations(db);
+            std::copy(perOperation.begin(), perOperation.end(), counters.begin() + 3);
+            for (size_t i = 0; i < counters.size(); i++) {
+                printPerf(std::string(PERF_SCOPES[i]) + (i < 3 ? " per row" : " per operation"), counters[i],
+                          i < 3 ? std::max<size_t>(1, db.rowCount()) : 1);
+            }
+        }
 
         // Save to CSV
         if (benchmarkFile.is_open()) {
             benchmarkFile << variantName << "," << datasetSize << "," 
                          << std::fixed << std::setprecision(4) << loadTime << "," 
-                         << memoryKB << "," << opsCount << std::endl;
+                         << loadAllocations << "," << snapshotLoadTime << "," << memoryKB << "," << measuredKB;
+            for (const auto& usage : heap) {
+                benchmarkFile << "," << usage.bytes / 1024 << "," << usage.allocations;
+            }
+            benchmarkFile << "," << rssKB << "," << filterKB << "," << filterFpr << "," << opsCount;
+            for (const auto& h : latencies) {
+                benchmarkFile << "," << h.percentile(50) << "," << h.percentile(90) << "," << h.percentile(99)
+                              << "," << h.percentile(99.9) << "," << h.max();
+            }
+            for (size_t i = 0; i < counters.size(); i++) {
+                writePerfColumns(benchmarkFile, counters[i], i < 3 ? db.rowCount() : 1);
+            }
+            benchmarkFile << std::endl;
         }
     }
 
-    void runSortBenchmark(size_t datasetSize, std::ofstream& sortFile) {
-        std::cout << "\nSort benchmark with " << datasetSize << " records:" << std::endl;
+    void runLoadScalingBenchmark(const std::string& variantName, IDatabase& db, size_t datasetSize,
+                                 const std::vector<size_t>& threadCounts, std::ofstream& loadFile) {
+        std::cout << "  Parallel load of " << variantName << " with " << datasetSize << " records:" << std::endl;
 
-        // Create subset of data
-        std::string filename = "test_sort_" + std::to_string(datasetSize) + ".csv";
+        std::string filename = "test_" + std::to_string(datasetSize) + ".csv";
         dataHelper.createSubset(filename, datasetSize);
 
-        HashMapDB db;
+        for (size_t threads : threadCounts) {
+            auto loadStart = std::chrono::high_resolution_clock::now();
+            db.loadFromFileParallel(filename, threads);
+            auto loadEnd = std::chrono::high_resolution_clock::now();
+            double loadTime = std::chrono::duration<double>(loadEnd - loadStart).count();
+
+            std::cout << "      " << threads << " threads: " << std::fixed << std::setprecision(3) << loadTime << "s" << std::endl;
+
+            if (loadFile.is_open()) {
+                loadFile << variantName << "," << datasetSize << "," << threads << ","
+                         << std::fixed << std::setprecision(4) << loadTime << std::endl;
+            }
+        }
+    }
+
+    // Serial loadFromFile against the read/parse/index pipeline, with the
+    // time each pipeline stage was busy
+    void runPipelineBenchmark(const std::string& variantName, IDatabase& db, size_t datasetSize,
+                              size_t parserThreads, std::ofstream& pipelineFile) {
+        std::cout << "  Pipelined load of " << variantName << " with " << datasetSize << " records:" << std::endl;
+
+        std::string filename = "test_" + std::to_string(datasetSize) + ".csv";
+        dataHelper.createSubset(filename, datasetSize);
+
+        auto serialStart = std::chrono::steady_clock::now();
         db.loadFromFile(filename);
-        
-        double standardTime = 0.0;
-        double radixTime = 0.0;
+        double serialTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - serialStart).count();
+        size_t serialRows = db.rowCount();
 
-        // Test std sort
-        {
-            auto students = db.getAllStudents();
-            auto start = std::chrono::high_resolution_clock::now();
-            Sorter::standardSort(students);
-            auto end = std::chrono::high_resolution_clock::now();
-            standardTime = std::chrono::duration<double>(end - start).count();
-            std::cout << "  Standard sort: " << std::fixed << std::setprecision(4) << standardTime << "s" << std::endl;
-            Sorter::saveToCSV(students, "sorted_standard.csv");
+        PipelinedLoader loader(parserThreads);
+        if (!loader.load(db, filename) || db.rowCount() != serialRows) {
+            std::cout << "      pipelined load failed" << std::endl;
+            return;
+        }
+        const PipelineStats& stats = loader.stats();
+
+        std::cout << "      serial " << std::fixed << std::setprecision(3) << serialTime << "s, pipelined "
+                  << stats.totalTime << "s with " << parserThreads << " parsers (read " << stats.readTime
+                  << "s, parse " << stats.parseTime << "s, index " << stats.indexTime << "s, build at end "
+                  << stats.buildTime << "s, indexer waited "
+                  << stats.waitTime << "s)" << std::endl;
+        if (pipelineFile.is_open()) {
+            pipelineFile << variantName << "," << datasetSize << "," << parserThreads << ","
+                         << std::fixed << std::setprecision(4) << serialTime << "," << stats.totalTime << ","
+                         << stats.readTime << "," << stats.parseTime << "," << stats.indexTime << ","
+                         << stats.buildTime << "," << stats.waitTime << std::endl;
         }
+    }
+
+    // Aggregate throughput of the 5:5:50 mix with 1..N threads sharing one database
+    void runConcurrentBenchmark(const std::string& variantName, IDatabase& db, size_t datasetSize,
+                                const std::vector<size_t>& threadCounts, std::ofstream& concurrentFile) {
+        std::cout << "  Concurrent operations on " << variantName << " with " << datasetSize << " records:" << std::endl;
+
+        std::string filename = "test_" + std::to_string(datasetSize) + ".csv";
+        dataHelper.createSubset(filename, datasetSize);
+        db.loadFromFile(filename);
+
+        const double timeLimit = 2.0;
+        for (size_t threads : threadCounts) {
+            size_t opsCount = runConcurrentOperations(db, datasetSize, threads, options.workload.findWeight,
+                                                      options.workload.groupsWeight, options.workload.updateWeight, timeLimit);
+            double opsPerSecond = opsCount / timeLimit;
+
+            std::cout << "      " << threads << " threads: " << std::fixed << std::setprecision(0)
+                      << opsPerSecond << " ops/s" << std::endl;
+
+            if (concurrentFile.is_open()) {
+                concurrentFile << variantName << "," << datasetSize << "," << threads << ","
+                               << std::fixed << std::setprecision(1) << opsPerSecond << std::endl;
+            }
+        }
+    }
 
-        // Test my radix sort
+    // The current trace's mix on Variant 1 with every change logged under
+    // each commit policy, then a restart: load the CSV and replay the log
+    void runDurabilityBenchmark(size_t datasetSize, std::ofstream& durabilityFile) {
+        struct Policy {
+            const char* name;
+            bool durable;
+            CommitPolicy commit;
+        };
+        const Policy policies[] = {
+            {"Off", false, {}},
+            {"Buffered", true, {0, 0}},
+            {"EveryUpdate", true, {1, 0}},
+            {"Batch16", true, {16, 0}},
+            {"Batch256", true, {256, 0}},
+            {"Interval1ms", true, {0, 1000}},
+            {"Interval10ms", true, {0, 10000}},
+        };
+
+        std::string filename = "test_" + std::to_string(datasetSize) + ".csv";
+        std::string logFilename = "test_" + std::to_string(datasetSize) + ".wal";
+        dataHelper.createSubset(filename, datasetSize);
+
+        const double timeLimit = 2.0;
+        for (const Policy& policy : policies) {
+            std::cout << "  " << policy.name << " with " << datasetSize << " records:" << std::endl;
+            std::remove(logFilename.c_str());
+
+            HashMapDB base;
+            DurableDB durable(base, logFilename, policy.commit);
+            IDatabase& db = policy.durable ? static_cast<IDatabase&>(durable) : base;
+            db.loadFromFile(filename);
+
+            std::array<LatencyHistogram, 3> latencies;
+            auto start = std::chrono::steady_clock::now();
+            size_t opsCount = runOperations(db, timeLimit, latencies);
+            bool committed = !policy.durable || durable.commit();
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            double opsPerSecond = opsCount / elapsed;
+            size_t logged = policy.durable ? durable.loggedCount() : 0;
+            size_t syncs = policy.durable ? durable.syncCount() : 0;
+
+            // Restart: a fresh database loads the CSV and replays the log
+            double restartTime = 0.0;
+            size_t replayed = 0;
+            if (policy.durable) {
+                HashMapDB restartedBase;
+                DurableDB restarted(restartedBase, logFilename, policy.commit);
+                auto restartStart = std::chrono::steady_clock::now();
+                restarted.loadFromFile(filename);
+                restartTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - restartStart).count();
+                replayed = restarted.replayedCount();
+            }
+
+            std::cout << "      " << std::fixed << std::setprecision(0) << opsPerSecond << " ops/s, "
+                      << logged << " changes logged in " << syncs << " fsyncs";
+            if (policy.durable) {
+                std::cout << ", restart " << std::setprecision(3) << restartTime << "s replaying " << replayed;
+            }
+            if (!committed || replayed != logged) std::cout << " (log incomplete!)";
+            std::cout << std::endl;
+
+            if (durabilityFile.is_open()) {
+                durabilityFile << policy.name << "," << datasetSize << "," << std::fixed << std::setprecision(1)
+                               << opsPerSecond << "," << latencies[2].percentile(50) << "," << latencies[2].percentile(99)
+                               << "," << logged << "," << syncs << "," << replayed << "," << std::setprecision(4)
+                               << restartTime << std::endl;
+            }
+        }
+        std::remove(logFilename.c_str());
+    }
+
+    // A roster delta of 1% of the rows (half changed groups, half new
+    // students) and as many removals, applied in place vs. a full reload
+    void runIncrementalBenchmark(const std::string& variantName, IDatabase& db, size_t datasetSize,
+                                 std::ofstream& incrementalFile) {
+        std::string filename = "test_" + std::to_string(datasetSize) + ".csv";
+        std::string deltaFilename = "delta_" + std::to_string(datasetSize) + ".csv";
+        dataHelper.createSubset(filename, datasetSize);
+
+        const std::vector<Student>& all = dataHelper.students();
+        size_t loaded = std::min(datasetSize, all.size());
+        if (loaded == 0) return;
+        size_t deltaRows = std::max<size_t>(1, datasetSize / 100);
+        std::mt19937 gen(options.workload.seed + datasetSize);
+        std::vector<std::string> removals;
         {
-            auto students = db.getAllStudents();
+            CsvWriter writer(deltaFilename);
+            for (size_t i = 0; i < deltaRows; i++) {
+                Student s = all[gen() % loaded];
+                if (i % 2 == 0) {
+                    s.m_group = dataHelper.getRandomGroup(gen);
+                } else {
+                    s.m_email = "delta" + std::to_string(i) + "." + s.m_email;
+                }
+                writer.writeStudent(s);
+                removals.push_back(all[gen() % loaded].m_email);
+            }
+            if (!writer.close()) return;
+        }
+
+        std::cout << "  Incremental delta on " << variantName << " with " << datasetSize << " records:" << std::endl;
+        // The delta goes into the still empty database first: every row must be found by name
+        if (db.appendFromFile(deltaFilename)) {
+            std::vector<size_t> scratch;
+            size_t missing = 0;
+            for (size_t row = 0; row < db.rowCount(); row++) {
+                StudentView s = db.getRow(row);
+                missing += db.findRowsByNameSurname(std::string(s.m_name), std::string(s.m_surname), scratch).empty();
+            }
+            if (missing > 0) std::cout << "      upsert before load lost " << missing << " rows!" << std::endl;
+        }
+        db.loadFromFile(filename);
+        auto start = std::chrono::steady_clock::now();
+        if (!db.appendFromFile(deltaFilename)) {
+            std::cout << "      not supported" << std::endl;
+            return;
+        }
+        auto appended = std::chrono::steady_clock::now();
+        size_t removed = 0;
+        for (const auto& email : removals) {
+            removed += db.removeByEmail(email);
+        }
+        auto end = std::chrono::steady_clock::now();
+        db.loadFromFile(filename);
+        double reloadTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - end).count();
+        double appendTime = std::chrono::duration<double>(appended - start).count();
+        double removeTime = std::chrono::duration<double>(end - appended).count();
+
+        std::cout << "      " << deltaRows << " upserts in " << std::fixed << std::setprecision(6) << appendTime
+                  << "s, " << removed << " removals in " << removeTime << "s, full reload " << reloadTime << "s"
+                  << std::endl;
+        if (incrementalFile.is_open()) {
+            incrementalFile << variantName << "," << datasetSize << "," << deltaRows << "," << removed << ","
+                            << std::fixed << std::setprecision(6) << appendTime << "," << removeTime << ","
+                            << reloadTime << std::endl;
+        }
+        std::remove(deltaFilename.c_str());
+    }
+
+    // Operation 1 and 3 throughput through single calls vs. the batch API,
+    // on the same pre-generated requests so key generation is not timed
+    void runBatchBenchmark(const std::string& variantName, IDatabase& db, size_t datasetSize,
+                           size_t batchSize, std::ofstream& batchFile) {
+        std::cout << "  Batched operations on " << variantName << " with " << datasetSize << " records:" << std::endl;
+
+        std::string filename = "test_" + std::to_string(datasetSize) + ".csv";
+        dataHelper.createSubset(filename, datasetSize);
+        db.loadFromFile(filename);
+
+        std::vector<NameQuery> queries(batchSize);
+        std::vector<GroupUpdate> updates(batchSize);
+        for (size_t i = 0; i < batchSize; i++) {
+            queries[i] = {dataHelper.getRandomName(), dataHelper.getRandomSurname()};
+            updates[i] = {dataHelper.getRandomEmail(datasetSize), dataHelper.getRandomGroup()};
+        }
+
+        // Repeats runBatch for timeLimit seconds, returns requests per second
+        const double timeLimit = 1.0;
+        auto throughput = [&](auto runBatch) {
             auto start = std::chrono::high_resolution_clock::now();
-            Sorter::radixSort(students);
-            auto end = std::chrono::high_resolution_clock::now();
-            radixTime = std::chrono::duration<double>(end - start).count();
-            std::cout << "  Radix sort: " << std::fixed << std::setprecision(4) << radixTime << "s" << std::endl;
-            Sorter::saveToCSV(students, "sorted_radix.csv");
+            size_t batches = 0;
+            double elapsed = 0.0;
+            do {
+                runBatch();
+                batches++;
+                elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            } while (elapsed < timeLimit);
+            return batches * batchSize / elapsed;
+        };
+
+        std::vector<size_t> scratch;
+        std::vector<RowSpan> results;
+        double singleLookups = throughput([&] {
+            for (const auto& q : queries) {
+                db.findRowsByNameSurname(q.name, q.surname, scratch);
+            }
+        });
+        double batchLookups = throughput([&] { db.findRowsByNameSurnameBatch(queries, results, scratch); });
+        double singleUpdates = throughput([&] {
+            for (const auto& u : updates) {
+                db.updateGroupByEmail(u.email, u.newGroup);
+            }
+        });
+        double batchUpdates = throughput([&] { db.updateGroupByEmailBatch(updates); });
+
+        std::cout << std::fixed << std::setprecision(0)
+                  << "      Lookups/s: " << singleLookups << " single, " << batchLookups << " batched" << std::endl
+                  << "      Updates/s: " << singleUpdates << " single, " << batchUpdates << " batched" << std::endl;
+
+        if (batchFile.is_open()) {
+            batchFile << variantName << "," << datasetSize << "," << batchSize << "," << std::fixed << std::setprecision(1)
+                      << singleLookups << "," << batchLookups << "," << singleUpdates << "," << batchUpdates << std::endl;
         }
+    }
 
-        // Save to CSV
-        if (sortFile.is_open()) {
-            sortFile << datasetSize << "," << std::fixed << std::setprecision(4) 
-                    << standardTime << "," << radixTime << std::endl;
+    // Both sorts at every thread count; 1 thread is the serial std::sort and radix sort
+    void runSortBenchmark(size_t datasetSize, const std::vector<size_t>& threadCounts, std::ofstream& sortFile) {
+        std::cout << "\nSort benchmark with " << datasetSize << " records:" << std::endl;
+
+        // Create subset of data; sizes past the dataset reuse its rows, which only adds equal keys
+        std::string filename = "test_sort_" + std::to_string(datasetSize) + ".csv";
+        dataHelper.createSubset(filename, datasetSize, true);
+
+        HashMapDB db;
+        db.loadFromFile(filename);
+
+        // Materialize once; every run sorts its own copy
+        std::vector<Student> loaded = db.getAllStudents();
+
+        for (size_t threads : threadCounts) {
+            double standardTime = 0.0;
+            double radixTime = 0.0;
+            double exportTime = 0.0;
+
+            // Test std sort (parallel merge sort past 1 thread)
+            {
+                auto students = loaded;
+                auto start = std::chrono::high_resolution_clock::now();
+                Sorter::standardSort(students, threads);
+                auto end = std::chrono::high_resolution_clock::now();
+                standardTime = std::chrono::duration<double>(end - start).count();
+                if (threads == 1) Sorter::saveToCSV(students, "sorted_standard.csv");
+            }
+
+            // Test my radix sort
+            {
+                auto students = loaded;
+                auto start = std::chrono::high_resolution_clock::now();
+                Sorter::radixSort(students, threads);
+                auto end = std::chrono::high_resolution_clock::now();
+                radixTime = std::chrono::duration<double>(end - start).count();
+                if (threads == 1) {
+                    auto exportStart = std::chrono::high_resolution_clock::now();
+                    Sorter::saveToCSV(students, "sorted_radix.csv");
+                    auto exportEnd = std::chrono::high_resolution_clock::now();
+                    exportTime = std::chrono::duration<double>(exportEnd - exportStart).count();
+                }
+            }
+
+            // External sort with a budget far below the data, so it spills and merges runs
+            const size_t externalBudget = 16 * 1024 * 1024;
+            ExternalSorter externalSorter(externalBudget, threads);
+            auto externalStart = std::chrono::high_resolution_clock::now();
+            bool externalOk = externalSorter.sort(filename, "sorted_external.csv");
+            auto externalEnd = std::chrono::high_resolution_clock::now();
+            double externalTime = std::chrono::duration<double>(externalEnd - externalStart).count();
+
+            std::cout << "  " << threads << " threads:" << std::endl;
+            std::cout << "    Standard sort: " << std::fixed << std::setprecision(4) << standardTime << "s" << std::endl;
+            std::cout << "    Radix sort: " << std::fixed << std::setprecision(4) << radixTime << "s" << std::endl;
+            if (threads == 1) {
+                std::cout << "    Export (saveToCSV): " << exportTime << "s" << std::endl;
+            }
+            std::cout << "    External sort (" << externalBudget / (1024 * 1024) << " MB budget): " << externalTime << "s, "
+                      << externalSorter.runCount() << " runs, " << externalSorter.mergePassCount() << " merge passes"
+                      << (externalOk ? "" : " (failed)") << std::endl;
+
+            // Save to CSV
+            if (sortFile.is_open()) {
+                sortFile << datasetSize << "," << threads << "," << std::fixed << std::setprecision(4)
+                        << standardTime << "," << radixTime << "," << externalTime << std::endl;
+            }
         }
+
+        // Report orders through the generic multi-key sort
+        auto timeSort = [&](const char* label, auto sort) {
+            auto students = loaded;
+            auto start = std::chrono::high_resolution_clock::now();
+            sort(students);
+            auto end = std::chrono::high_resolution_clock::now();
+            std::cout << "  " << label << ": " << std::fixed << std::setprecision(4)
+                      << std::chrono::duration<double>(end - start).count() << "s" << std::endl;
+        };
+        timeSort("sortBy group", [](std::vector<Student>& students) {
+            Sorter::sortBy<SortKey<&Student::m_group>>(students);
+        });
+        timeSort("sortBy rating (descending)", [](std::vector<Student>& students) {
+            Sorter::sortBy<Desc<SortKey<&Student::m_rating>>>(students);
+        });
+        timeSort("sortBy birth date", [](std::vector<Student>& students) {
+            Sorter::sortBy<SortKey<&Student::m_birth_year>, SortKey<&Student::m_birth_month>,
+                           SortKey<&Student::m_birth_day>>(students);
+        });
     }
 };
 
-int main() {
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --seed N              seed of every random choice (default: random, printed at start)\n"
+              << "  --mix A:B:C           weights of operations 1, 2 and 3 (default 5:5:50)\n"
+              << "  --sizes N,N,...       dataset sizes (default 100,1000,10000,100000)\n"
+              << "  --time SECONDS        operation time per variant; 0 replays each trace once (default 10)\n"
+              << "  --trace-length N      operations per generated trace (default 1048576)\n"
+              << "  --name-skew S         Zipf exponent of names and surnames (default 0, uniform)\n"
+              << "  --email-skew S        Zipf exponent of emails (default 0, uniform)\n"
+              << "  --save-trace PREFIX   save each size's trace to PREFIX_<size>.trace\n"
+              << "  --replay-trace PREFIX replay PREFIX_<size>.trace instead of generating traces\n"
+              << "  --perf SECONDS        count cycles, instructions, cache and branch misses and page faults\n"
+              << "                        per load phase and per operation type, profiling each type for up\n"
+              << "                        to SECONDS (default 0, off)\n"
+              << "  --options LIST        also run the variants with each listed option: incdup, bloom,\n"
+              << "                        perfect-email or all (default none)" << std::endl;
+}
+
+// Fills options from the command line; false (after saying why) on a bad argument
+static bool parseOptions(int argc, char* argv[], BenchmarkOptions& options) {
+    bool seeded = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || i + 1 >= argc) {
+            if (arg != "--help") std::cerr << "Missing value for " << arg << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+        std::string value = argv[++i];
+        bool valid = true;
+        try {
+            if (arg == "--seed") {
+                options.workload.seed = std::stoull(value);
+                seeded = true;
+            } else if (arg == "--mix") {
+                WorkloadConfig& w = options.workload;
+                valid = std::sscanf(value.c_str(), "%d:%d:%d", &w.findWeight, &w.groupsWeight, &w.updateWeight) == 3 &&
+                        w.findWeight >= 0 && w.groupsWeight >= 0 && w.updateWeight >= 0 &&
+                        w.findWeight + w.groupsWeight + w.updateWeight > 0;
+            } else if (arg == "--sizes") {
+                options.sizes.clear();
+                std::stringstream list(value);
+                for (std::string size; std::getline(list, size, ',');) {
+                    options.sizes.push_back(std::stoull(size));
+                    valid &= options.sizes.back() > 0;
+                }
+                valid &= !options.sizes.empty();
+            } else if (arg == "--time") {
+                options.timeLimit = std::stod(value);
+                valid = options.timeLimit >= 0.0;
+            } else if (arg == "--trace-length") {
+                options.traceLength = std::stoull(value);
+                valid = options.traceLength > 0;
+            } else if (arg == "--name-skew") {
+                options.workload.nameSkew = std::stod(value);
+                valid = options.workload.nameSkew >= 0.0;
+            } else if (arg == "--email-skew") {
+                options.workload.emailSkew = std::stod(value);
+                valid = options.workload.emailSkew >= 0.0;
+            } else if (arg == "--save-trace") {
+                options.saveTracePrefix = value;
+            } else if (arg == "--replay-trace") {
+                options.replayTracePrefix = value;
+            } else if (arg == "--perf") {
+                options.perfTime = std::stod(value);
+                valid = options.perfTime >= 0.0;
+            } else if (arg == "--options") {
+                DatabaseOptions& runs = options.optionRuns;
+                std::stringstream list(value);
+                for (std::string option; std::getline(list, option, ',');) {
+                    bool all = option == "all";
+                    bool known = all || option == "incdup" || option == "bloom" || option == "perfect-email";
+                    runs.incrementalDuplicates |= all || option == "incdup";
+                    runs.nameFilter |= all || option == "bloom";
+                    runs.perfectEmailIndex |= all || option == "perfect-email";
+                    valid &= known;
+                }
+            } else {
+                std::cerr << "Unknown option " << arg << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+        } catch (const std::exception&) {
+            valid = false;
+        }
+        if (!valid) {
+            std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+            return false;
+        }
+    }
+    if (!seeded) options.workload.seed = std::random_device{}();
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, options)) return 1;
+
     std::cout << "=== Student Database Benchmark ===\n" << std::endl;
+    std::cout << "Scan kernel: " << scanKernelName(selectScanKernel()) << std::endl;
+    const WorkloadConfig& workload = options.workload;
+    std::cout << "Workload: seed " << workload.seed << ", mix " << workload.findWeight << ":" << workload.groupsWeight
+              << ":" << workload.updateWeight << ", name skew " << workload.nameSkew << ", email skew "
+              << workload.emailSkew << " (--seed " << workload.seed << " repeats this run)\n" << std::endl;
 
-    Benchmark benchmark;
+    Benchmark benchmark(options);
     
     std::cout << "Loading full dataset from students.csv..." << std::endl;
     try {
@@ -213,13 +1064,14 @@ int main() {
         return 1;
     }
 
-    std::vector<size_t> sizes = {100, 1000, 10000, 100000};
+    const std::vector<size_t>& sizes = options.sizes;
 
     // Open benchmark results file
     benchmark.openBenchmarkFile("benchmark_results.csv");
 
     for (size_t size : sizes) {
         std::cout << "\n--- Dataset size: " << size << " ---" << std::endl;
+        if (!benchmark.prepareWorkload(size)) return 1;
         
         {
             HashMapDB db1;
@@ -235,21 +1087,348 @@ int main() {
             MapDB db3;
             benchmark.runBenchmark("Variant3_Map_BST", db3, size);
         }
+
+        {
+            ColumnarDB db4;
+            benchmark.runBenchmark("Variant4_Columnar", db4, size);
+        }
+
+        {
+            ArenaDB db5;
+            benchmark.runBenchmark("Variant5_Arena", db5, size);
+        }
+
+        {
+            FlatHashDB db6;
+            benchmark.runBenchmark("Variant6_FlatHash", db6, size);
+        }
+
+        {
+            ConcurrentDB db7;
+            benchmark.runBenchmark("Variant7_Concurrent", db7, size);
+        }
+
+        {
+            MappedDB db8;
+            benchmark.runBenchmark("Variant8_Mapped", db8, size);
+        }
+
+        // Same variants with duplicate groups maintained on update
+        if (options.optionRuns.incrementalDuplicates) {
+            DatabaseOptions incremental;
+            incremental.incrementalDuplicates = true;
+
+            {
+                HashMapDB db1(incremental);
+                benchmark.runBenchmark("Variant1_HashMap_IncDup", db1, size);
+            }
+
+            {
+                MixedDB db2(incremental);
+                benchmark.runBenchmark("Variant2_Mixed_IncDup", db2, size);
+            }
+
+            {
+                MapDB db3(incremental);
+                benchmark.runBenchmark("Variant3_Map_BST_IncDup", db3, size);
+            }
+        }
+
+        // Every variant with the name filter in front of operation 1
+        if (options.optionRuns.nameFilter) {
+            DatabaseOptions filtered;
+            filtered.nameFilter = true;
+
+            {
+                HashMapDB db1(filtered);
+                benchmark.runBenchmark("Variant1_HashMap_Bloom", db1, size);
+            }
+
+            {
+                MixedDB db2(filtered);
+                benchmark.runBenchmark("Variant2_Mixed_Bloom", db2, size);
+            }
+
+            {
+                MapDB db3(filtered);
+                benchmark.runBenchmark("Variant3_Map_BST_Bloom", db3, size);
+            }
+
+            {
+                ColumnarDB db4(filtered);
+                benchmark.runBenchmark("Variant4_Columnar_Bloom", db4, size);
+            }
+
+            {
+                ArenaDB db5(filtered);
+                benchmark.runBenchmark("Variant5_Arena_Bloom", db5, size);
+            }
+
+            {
+                FlatHashDB db6(filtered);
+                benchmark.runBenchmark("Variant6_FlatHash_Bloom", db6, size);
+            }
+        }
+
+        // Every variant with the email index replaced by a minimal perfect hash
+        if (options.optionRuns.perfectEmailIndex) {
+            DatabaseOptions perfect;
+            perfect.perfectEmailIndex = true;
+
+            {
+                HashMapDB db1(perfect);
+                benchmark.runBenchmark("Variant1_HashMap_PerfectEmail", db1, size);
+            }
+
+            {
+                MixedDB db2(perfect);
+                benchmark.runBenchmark("Variant2_Mixed_PerfectEmail", db2, size);
+            }
+
+            {
+                MapDB db3(perfect);
+                benchmark.runBenchmark("Variant3_Map_BST_PerfectEmail", db3, size);
+            }
+
+            {
+                ColumnarDB db4(perfect);
+                benchmark.runBenchmark("Variant4_Columnar_PerfectEmail", db4, size);
+            }
+
+            {
+                ArenaDB db5(perfect);
+                benchmark.runBenchmark("Variant5_Arena_PerfectEmail", db5, size);
+            }
+
+            {
+                FlatHashDB db6(perfect);
+                benchmark.runBenchmark("Variant6_FlatHash_PerfectEmail", db6, size);
+            }
+
+            {
+                ConcurrentDB db7(perfect);
+                benchmark.runBenchmark("Variant7_Concurrent_PerfectEmail", db7, size);
+            }
+        }
     }
 
     benchmark.closeBenchmarkFile();
 
+    std::cout << "\n\n=== Parallel Load Benchmarks ===" << std::endl;
+    std::ofstream loadFile("load_results.csv");
+    loadFile << "Variant,DatasetSize,Threads,LoadTime" << std::endl;
+
+    std::vector<size_t> threadCounts;
+    for (size_t threads = 1; threads < hardwareThreads(); threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(hardwareThreads());
+
+    for (size_t size : sizes) {
+        std::cout << "\n--- Dataset size: " << size << " ---" << std::endl;
+
+        {
+            HashMapDB db1;
+            benchmark.runLoadScalingBenchmark("Variant1_HashMap", db1, size, threadCounts, loadFile);
+        }
+
+        {
+            MixedDB db2;
+            benchmark.runLoadScalingBenchmark("Variant2_Mixed", db2, size, threadCounts, loadFile);
+        }
+
+        {
+            MapDB db3;
+            benchmark.runLoadScalingBenchmark("Variant3_Map_BST", db3, size, threadCounts, loadFile);
+        }
+
+        {
+            FlatHashDB db6;
+            benchmark.runLoadScalingBenchmark("Variant6_FlatHash", db6, size, threadCounts, loadFile);
+        }
+    }
+
+    loadFile.close();
+
+    std::cout << "\n\n=== Pipelined Load Benchmarks ===" << std::endl;
+    std::ofstream pipelineFile("pipeline_results.csv");
+    pipelineFile << "Variant,DatasetSize,ParserThreads,SerialLoadTime,PipelineLoadTime,ReadTime,ParseTime,IndexTime,BuildTime,WaitTime" << std::endl;
+
+    for (size_t size : sizes) {
+        std::cout << "\n--- Dataset size: " << size << " ---" << std::endl;
+
+        {
+            HashMapDB db1;
+            benchmark.runPipelineBenchmark("Variant1_HashMap", db1, size, hardwareThreads(), pipelineFile);
+        }
+
+        {
+            MixedDB db2;
+            benchmark.runPipelineBenchmark("Variant2_Mixed", db2, size, hardwareThreads(), pipelineFile);
+        }
+
+        {
+            MapDB db3;
+            benchmark.runPipelineBenchmark("Variant3_Map_BST", db3, size, hardwareThreads(), pipelineFile);
+        }
+
+        {
+            ColumnarDB db4;
+            benchmark.runPipelineBenchmark("Variant4_Columnar", db4, size, hardwareThreads(), pipelineFile);
+        }
+
+        {
+            ArenaDB db5;
+            benchmark.runPipelineBenchmark("Variant5_Arena", db5, size, hardwareThreads(), pipelineFile);
+        }
+
+        {
+            FlatHashDB db6;
+            benchmark.runPipelineBenchmark("Variant6_FlatHash", db6, size, hardwareThreads(), pipelineFile);
+        }
+
+        {
+            ConcurrentDB db7;
+            benchmark.runPipelineBenchmark("Variant7_Concurrent", db7, size, hardwareThreads(), pipelineFile);
+        }
+    }
+
+    pipelineFile.close();
+
+    std::cout << "\n\n=== Concurrent Operation Benchmarks ===" << std::endl;
+    std::ofstream concurrentFile("concurrent_results.csv");
+    concurrentFile << "Variant,DatasetSize,Threads,OpsPerSecond" << std::endl;
+
+    for (size_t size : sizes) {
+        std::cout << "\n--- Dataset size: " << size << " ---" << std::endl;
+
+        {
+            HashMapDB db1;
+            SharedLockDB locked(db1);
+            benchmark.runConcurrentBenchmark("Variant1_HashMap_SharedLock", locked, size, threadCounts, concurrentFile);
+        }
+
+        {
+            FlatHashDB db6;
+            SharedLockDB locked(db6);
+            benchmark.runConcurrentBenchmark("Variant6_FlatHash_SharedLock", locked, size, threadCounts, concurrentFile);
+        }
+
+        {
+            ConcurrentDB db7;
+            benchmark.runConcurrentBenchmark("Variant7_Concurrent", db7, size, threadCounts, concurrentFile);
+        }
+    }
+
+    concurrentFile.close();
+
+    std::cout << "\n\n=== Durable Update Benchmarks ===" << std::endl;
+    std::ofstream durabilityFile("durability_results.csv");
+    durabilityFile << "Policy,DatasetSize,OpsPerSecond,UpdateP50Ns,UpdateP99Ns,LoggedUpdates,Syncs,ReplayedUpdates,RestartTime" << std::endl;
+
+    for (size_t size : sizes) {
+        std::cout << "\n--- Dataset size: " << size << " ---" << std::endl;
+        if (!benchmark.prepareWorkload(size)) return 1;
+        benchmark.runDurabilityBenchmark(size, durabilityFile);
+    }
+
+    durabilityFile.close();
+
+    std::cout << "\n\n=== Incremental Ingestion Benchmarks ===" << std::endl;
+    std::ofstream incrementalFile("incremental_results.csv");
+    incrementalFile << "Variant,DatasetSize,DeltaRows,Removals,AppendTime,RemoveTime,ReloadTime" << std::endl;
+
+    for (size_t size : sizes) {
+        std::cout << "\n--- Dataset size: " << size << " ---" << std::endl;
+
+        {
+            HashMapDB db1;
+            benchmark.runIncrementalBenchmark("Variant1_HashMap", db1, size, incrementalFile);
+        }
+
+        {
+            DatabaseOptions perfect;
+            perfect.perfectEmailIndex = true;
+            HashMapDB db1(perfect);
+            benchmark.runIncrementalBenchmark("Variant1_HashMap_PerfectEmail", db1, size, incrementalFile);
+        }
+
+        {
+            MixedDB db2;
+            benchmark.runIncrementalBenchmark("Variant2_Mixed", db2, size, incrementalFile);
+        }
+
+        {
+            MapDB db3;
+            benchmark.runIncrementalBenchmark("Variant3_Map_BST", db3, size, incrementalFile);
+        }
+
+        // Upserted rows go into the name filter, which the first load would otherwise size
+        DatabaseOptions filtered;
+        filtered.nameFilter = true;
+
+        {
+            HashMapDB db1(filtered);
+            benchmark.runIncrementalBenchmark("Variant1_HashMap_Bloom", db1, size, incrementalFile);
+        }
+
+        {
+            MixedDB db2(filtered);
+            benchmark.runIncrementalBenchmark("Variant2_Mixed_Bloom", db2, size, incrementalFile);
+        }
+
+        {
+            MapDB db3(filtered);
+            benchmark.runIncrementalBenchmark("Variant3_Map_BST_Bloom", db3, size, incrementalFile);
+        }
+    }
+
+    incrementalFile.close();
+
+    std::cout << "\n\n=== Batched Operation Benchmarks ===" << std::endl;
+    std::ofstream batchFile("batch_results.csv");
+    batchFile << "Variant,DatasetSize,BatchSize,SingleLookupsPerSec,BatchLookupsPerSec,SingleUpdatesPerSec,BatchUpdatesPerSec" << std::endl;
+
+    const size_t batchSize = 4096;
+    for (size_t size : sizes) {
+        std::cout << "\n--- Dataset size: " << size << " ---" << std::endl;
+
+        {
+            HashMapDB db1;
+            benchmark.runBatchBenchmark("Variant1_HashMap", db1, size, batchSize, batchFile);
+        }
+
+        {
+            MixedDB db2;
+            benchmark.runBatchBenchmark("Variant2_Mixed", db2, size, batchSize, batchFile);
+        }
+
+        {
+            MapDB db3;
+            benchmark.runBatchBenchmark("Variant3_Map_BST", db3, size, batchSize, batchFile);
+        }
+
+        {
+            FlatHashDB db6;
+            benchmark.runBatchBenchmark("Variant6_FlatHash", db6, size, batchSize, batchFile);
+        }
+    }
+
+    batchFile.close();
+
     std::cout << "\n\n=== Sort Benchmarks ===" << std::endl;
     std::ofstream sortFile("sort_results.csv");
-    sortFile << "DatasetSize,StandardSort,RadixSort" << std::endl;
+    sortFile << "DatasetSize,Threads,StandardSort,RadixSort,ExternalSort" << std::endl;
 
-    for (size_t size : sizes) {
-        benchmark.runSortBenchmark(size, sortFile);
+    std::vector<size_t> sortSizes = sizes;
+    sortSizes.push_back(1000000);
+    for (size_t size : sortSizes) {
+        benchmark.runSortBenchmark(size, threadCounts, sortFile);
     }
 
     sortFile.close();
 
-    std::cout << "\n\nBenchmark results saved to benchmark_results.csv and sort_results.csv" << std::endl;
+    std::cout << "\n\nBenchmark results saved to benchmark_results.csv, load_results.csv, pipeline_results.csv, concurrent_results.csv, durability_results.csv, incremental_results.csv, batch_results.csv and sort_results.csv" << std::endl;
 
     return 0;
 }